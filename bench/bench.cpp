@@ -0,0 +1,938 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "code_object.h"
+#include "compiler.h"
+#include "event_loop.h"
+#include "ir_compiler.h"
+#include "number.h"
+#include "object.h"
+#include "parallel_compiler.h"
+#include "profiler.h"
+#include "repl.h"
+#include "script_runner.h"
+#include "string_space.h"
+#include "table.h"
+#include "vm.h"
+
+using Clock = std::chrono::steady_clock;
+
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+struct Benchmark {
+    std::string name;
+    // each call runs in a forked child, so every benchmark starts from a fresh vm
+    std::function<bool(Metrics &metrics)> run;
+    // optional extra child run for metrics that would disturb the timings
+    std::function<bool(Metrics &metrics)> count;
+};
+
+struct Options {
+    int repeat = 3;
+    bool jit = false;
+    bool list = false;
+    const char *filter = nullptr;
+};
+
+static Options options;
+
+static double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static bool timeScript(const std::string &source, Metrics &metrics) {
+    VM vm;
+    vm.setJitEnabled(options.jit);
+
+    Clock::time_point start = Clock::now();
+    Compiler compiler(vm);
+    ObjFunction *function = compiler.compile(source.c_str());
+    metrics.emplace_back("compile_ms", elapsedMs(start));
+    if (function == nullptr) return false;
+
+    start = Clock::now();
+    VM::InterpretResult result = vm.interpret(function);
+    metrics.emplace_back("run_ms", elapsedMs(start));
+    return result == VM::InterpretResult::Ok;
+}
+
+static bool countScript(const std::string &source, Metrics &metrics) {
+    Profiler profiler;
+    VM vm;
+    vm.setProfiler(&profiler);
+    VM::InterpretResult result = vm.interpret(source.c_str());
+    metrics.emplace_back("instructions", static_cast<double>(profiler.instructionCount()));
+    return result == VM::InterpretResult::Ok;
+}
+
+static Benchmark scriptBenchmark(const std::string &name, std::function<std::string()> source) {
+    return {
+            name,
+            [source](Metrics &metrics) { return timeScript(source(), metrics); },
+            [source](Metrics &metrics) { return countScript(source(), metrics); },
+    };
+}
+
+static std::string generateDeepNesting(int depth, int iterations) {
+    std::string source = "var total = 0;\nfor (var i = 0; i < " + std::to_string(iterations) + "; i = i + 1) {\n";
+    for (int d = 0; d < depth; d++) {
+        std::string local = "v" + std::to_string(d);
+        source += "{ var " + local + " = i; if (" + local + " >= 0) {\n";
+    }
+    source += "total = total + 1;\n";
+    for (int d = 0; d < depth; d++) {
+        source += "} }\n";
+    }
+    source += "}\nprint total;\n";
+    return source;
+}
+
+static std::string generateLargeSource(int lines) {
+    // globals and number literals each take one of the chunk's 256 constants, so stick to locals
+    std::string source = "{\nvar a = 1;\nvar b = 2;\nvar c = 0;\n";
+    for (int i = 0; i < lines; i++) {
+        source += "c = a + b - c; if (c > b) { c = c - a; } else { c = c + a; } b = -b;\n";
+    }
+    source += "print c;\n}\n";
+    return source;
+}
+
+// compiling a block with 200 locals and 40 nested blocks under it, whose body keeps referring to the
+// outermost locals, the ones a backwards scan reaches last
+static bool compileLocals(Metrics &metrics) {
+    const int outer = 200;
+    const int depth = 40;
+    const int lines = 5000;
+    std::string source = "{\n";
+    for (int i = 0; i < outer; i++) {
+        source += "var l" + std::to_string(i) + ";\n";
+    }
+    for (int d = 0; d < depth; d++) {
+        source += "{ var n" + std::to_string(d) + ";\n";
+    }
+    for (int i = 0; i < lines; i++) {
+        source += "l" + std::to_string(i % 20) + " = l" + std::to_string(i % 7) + " + n" + std::to_string(i % depth)
+                  + " + l" + std::to_string(i % 13) + ";\n";
+    }
+    for (int d = 0; d < depth; d++) {
+        source += "}\n";
+    }
+    source += "}\n";
+
+    const int runs = 20;
+    bool ok = true;
+    std::vector<double> times;
+    for (int run = 0; run < runs; run++) {
+        VM vm;
+        Compiler compiler(vm);
+        Clock::time_point start = Clock::now();
+        ok = compiler.compile(source.c_str()) != nullptr && ok;
+        times.push_back(elapsedMs(start));
+    }
+    std::sort(times.begin(), times.end());
+    metrics.emplace_back("compile_ms", times[runs / 2]);
+    metrics.emplace_back("ns_per_reference", times[runs / 2] * 1e6 / (lines * 4));
+    return ok;
+}
+
+// bytecode of function and every function among its constants
+static int codeBytes(const ObjFunction *function) { // NOLINT(misc-no-recursion)
+    int bytes = function->chunk.count();
+    for (int i = 0; i < function->chunk.constantCount(); i++) {
+        const Value &constant = function->chunk.constants()[i];
+        if (constant.isFunction()) bytes += codeBytes(constant.asFunction());
+    }
+    return bytes;
+}
+
+// locals holding settings that never change, the kind of code the ir passes fold away
+static std::string generateConstantLocals(int iterations) {
+    return "{\nvar debug = false; var scale = 4; var offset = 60 * 60; var total = 0;\n"
+           "for (var i = 0; i < " + std::to_string(iterations) + "; i = i + 1) {\n"
+           "  if (debug) print i;\n"
+           "  total = total + i * (scale * 2) + offset - (scale + 1) % 3;\n"
+           "  if (!debug and scale > 2) total = total - 1;\n"
+           "}\nprint total;\n}\n";
+}
+
+// every bench script compiled straight to bytecode and through the ir and its default pipeline,
+// totals of the time to compile, the time to run and the bytecode each way produces
+static bool irPipeline(Metrics &metrics) {
+    std::vector<std::string> sources;
+    for (const auto &entry: std::filesystem::directory_iterator(CPPLOX_BENCH_SCRIPTS)) {
+        if (entry.path().extension() == ".lox") sources.push_back(readFile(entry.path().string()));
+    }
+    sources.push_back(readFile(CPPLOX_SOURCE_DIR "/test.lox"));
+    sources.push_back(generateLargeSource(5000));
+    sources.push_back(generateConstantLocals(2000000));
+
+    bool ok = true;
+    auto run = [&](bool optimizing, const char *prefix) {
+        double compileMs = 0, runMs = 0;
+        int bytes = 0;
+        for (const std::string &source: sources) {
+            VM vm;
+            vm.setJitEnabled(options.jit);
+            vm.output().setSink([](const char *, size_t) {});
+
+            Clock::time_point start = Clock::now();
+            ObjFunction *function;
+            if (optimizing) {
+                IrCompiler compiler(vm);
+                function = compiler.compile(source.c_str());
+            } else {
+                Compiler compiler(vm);
+                function = compiler.compile(source.c_str());
+            }
+            compileMs += elapsedMs(start);
+            if (function == nullptr) {
+                ok = false;
+                continue;
+            }
+            bytes += codeBytes(function);
+
+            start = Clock::now();
+            ok = vm.interpret(function) == VM::InterpretResult::Ok && ok;
+            runMs += elapsedMs(start);
+        }
+        metrics.emplace_back(std::string(prefix) + "_compile_ms", compileMs);
+        metrics.emplace_back(std::string(prefix) + "_run_ms", runMs);
+        metrics.emplace_back(std::string(prefix) + "_code_bytes", bytes);
+    };
+
+    run(false, "direct");
+    run(true, "ir");
+    return ok;
+}
+
+// throughput of many small independent scripts as the pool grows towards the core count
+static bool poolScaling(Metrics &metrics) {
+    std::string script = "{ var sum = 0; for (var i = 0; i < 200000; i = i + 1) { sum = sum + i % 7; } print sum; }";
+    std::vector<std::string> sources(64, script);
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores < 1) cores = 1;
+    metrics.emplace_back("cores", cores);
+
+    double baseline = 0;
+    bool ok = true;
+    for (int jobs = 1;; jobs = std::min(jobs * 2, cores)) {
+        Clock::time_point start = Clock::now();
+        for (const ScriptResult &result: runScripts(sources, jobs, options.jit)) {
+            ok = ok && result.result == VM::InterpretResult::Ok;
+        }
+        double throughput = static_cast<double>(sources.size()) / (elapsedMs(start) / 1000.0);
+        if (jobs == 1) baseline = throughput;
+
+        std::string prefix = "jobs_" + std::to_string(jobs);
+        metrics.emplace_back(prefix + "_scripts_per_s", throughput);
+        metrics.emplace_back(prefix + "_speedup", throughput / baseline);
+        if (jobs == cores) break;
+    }
+    return ok;
+}
+
+// many vms running one script, compiled per vm against frozen once and shared
+static bool sharedCode(Metrics &metrics) {
+    std::string source = readFile(CPPLOX_SOURCE_DIR "/test.lox");
+    const int vms = 64;
+    bool ok = true;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < vms; i++) {
+        ok = ok && runScript(source, options.jit).result == VM::InterpretResult::Ok;
+    }
+    metrics.emplace_back("compile_each_ms", elapsedMs(start));
+
+    start = Clock::now();
+    std::shared_ptr<const CodeObject> code;
+    {
+        VM vm;
+        Compiler compiler(vm);
+        ObjFunction *function = compiler.compile(source.c_str());
+        if (function == nullptr) return false;
+        code = CodeObject::freeze(function, nullptr, options.jit);
+    }
+    if (code == nullptr) return false;
+    for (int i = 0; i < vms; i++) {
+        ok = ok && runCode(code).result == VM::InterpretResult::Ok;
+    }
+    metrics.emplace_back("shared_ms", elapsedMs(start));
+    return ok;
+}
+
+// many independent top-level blocks, one compile thread against max(cores, 4)
+static bool parallelCompile(Metrics &metrics) {
+    // number literals would each take a constant in the sequential compile, so stick to locals and keywords
+    std::string source;
+    for (int i = 0; i < 20000; i++) {
+        source += "{\n  var a = true;\n  var b = !a;\n  while (b or !a) { a = !a; b = a and b; }\n"
+                  "  if (a == b) { var c = a; b = c; } else { a = nil; }\n}\n";
+    }
+
+    int jobs = std::max(static_cast<int>(std::thread::hardware_concurrency()), 4);
+    metrics.emplace_back("jobs", jobs);
+
+    VM sequentialVM;
+    Clock::time_point start = Clock::now();
+    Compiler compiler(sequentialVM);
+    bool ok = compiler.compile(source.c_str()) != nullptr;
+    metrics.emplace_back("sequential_ms", elapsedMs(start));
+
+    VM parallelVM;
+    start = Clock::now();
+    ok = ok && compileParallel(parallelVM, source.c_str(), jobs) != nullptr;
+    metrics.emplace_back("parallel_ms", elapsedMs(start));
+    return ok;
+}
+
+// round robin over many fibers that do nothing but yield, one resume and yield pair per switch
+static bool fiberSwitch(Metrics &metrics) {
+    const int fibers = 1000;
+    const int yields = 1000;
+
+    VM vm;
+    vm.setJitEnabled(options.jit);
+    Compiler compiler(vm);
+    std::string source = "for (var i = 0; i < " + std::to_string(yields) + "; i = i + 1) yield i;";
+    ObjFunction *function = compiler.compile(source.c_str());
+    if (function == nullptr) return false;
+
+    std::vector<std::unique_ptr<Fiber>> running;
+    for (int i = 0; i < fibers; i++) {
+        running.push_back(vm.spawn(function));
+    }
+
+    long switches = 0;
+    bool ok = true;
+    Clock::time_point start = Clock::now();
+    while (!running.empty()) {
+        for (size_t i = 0; i < running.size();) {
+            VM::InterpretResult result = vm.resume(*running[i]);
+            switches++;
+            if (result == VM::InterpretResult::Yielded) {
+                i++;
+                continue;
+            }
+            ok = ok && result == VM::InterpretResult::Ok;
+            running[i] = std::move(running.back());
+            running.pop_back();
+        }
+    }
+    double ms = elapsedMs(start);
+
+    metrics.emplace_back("switches_per_s", static_cast<double>(switches) / (ms / 1000.0));
+    metrics.emplace_back("ns_per_switch", ms * 1e6 / static_cast<double>(switches));
+    return ok && switches == static_cast<long>(fibers) * (yields + 1);
+}
+
+// finite scripts sharing one thread with a script that never ends, round robin in budgeted slices
+static bool timeSlicing(Metrics &metrics) {
+    const int scripts = 8;
+    const int64_t slice = 1000;
+    std::string finite = "{ var sum = 0; for (var i = 0; i < 300000; i = i + 1) { sum = sum + i % 7; } }";
+
+    auto load = [](VM &vm, const std::string &source) {
+        vm.setJitEnabled(options.jit);
+        Compiler compiler(vm);
+        return compiler.compile(source.c_str());
+    };
+
+    Clock::time_point start = Clock::now();
+    bool ok = true;
+    for (int i = 0; i < scripts; i++) {
+        VM vm;
+        ObjFunction *function = load(vm, finite);
+        ok = ok && function != nullptr && vm.interpret(function) == VM::InterpretResult::Ok;
+    }
+    metrics.emplace_back("unsliced_ms", elapsedMs(start));
+
+    std::vector<std::unique_ptr<VM>> vms;
+    std::vector<ObjFunction *> functions;
+    std::vector<VM::InterpretResult> results(scripts + 1, VM::InterpretResult::Suspended);
+    for (int i = 0; i <= scripts; i++) {
+        vms.push_back(std::make_unique<VM>());
+        functions.push_back(load(*vms.back(), i < scripts ? finite : "while (true) {}"));
+        if (functions.back() == nullptr) return false;
+    }
+
+    start = Clock::now();
+    long slices = 0;
+    int finished = 0;
+    bool first = true;
+    while (finished < scripts) {
+        for (int i = 0; i <= scripts; i++) {
+            if (results[i] != VM::InterpretResult::Suspended) continue;
+            results[i] = first ? vms[i]->interpret(functions[i], slice) : vms[i]->run(slice);
+            slices++;
+            if (i < scripts && results[i] != VM::InterpretResult::Suspended) {
+                ok = ok && results[i] == VM::InterpretResult::Ok;
+                finished++;
+            }
+        }
+        first = false;
+    }
+    metrics.emplace_back("sliced_ms", elapsedMs(start));
+    metrics.emplace_back("slices", static_cast<double>(slices));
+    return ok && results[scripts] == VM::InterpretResult::Suspended;
+}
+
+// hundreds of fibers with i/o in flight on one thread: pipe writers and readers copying into temp files,
+// sleeping timers and child processes
+static bool eventLoopIo(Metrics &metrics) {
+    const int pairs = 200;
+    const int writes = 64;
+    const std::string chunk(1024, 'x');
+
+    char dir[] = "/tmp/cpplox_bench_XXXXXX";
+    if (mkdtemp(dir) == nullptr) return false;
+
+    VM vm;
+    vm.setJitEnabled(options.jit);
+    EventLoop loop(vm);
+    auto spawn = [&](const std::string &source) {
+        ObjFunction *function = vm.compile(source.c_str());
+        if (function != nullptr) loop.spawn(function);
+        return function != nullptr;
+    };
+
+    bool ok = true;
+    std::vector<std::string> paths;
+    for (int i = 0; i < pairs; i++) {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) return false;
+        std::string r = std::to_string(fds[0]);
+        std::string w = std::to_string(fds[1]);
+        paths.push_back(std::string(dir) + "/" + std::to_string(i));
+
+        ok = ok && spawn("for (var i = 0; i < " + std::to_string(writes) + "; i = i + 1) write(" + w + ", \"" +
+                         chunk + "\"); close(" + w + ");");
+        ok = ok && spawn("{ var out = open(\"" + paths.back() + "\", \"w\"); var s = read(" + r + "); "
+                         "while (s != nil) { write(out, s); s = read(" + r + "); } close(out); close(" + r + "); }");
+    }
+
+    Clock::time_point start = Clock::now();
+    ok = ok && loop.run();
+    double ms = elapsedMs(start);
+    metrics.emplace_back("pipes_ms", ms);
+    metrics.emplace_back("pipes_mb_per_s", pairs * writes * chunk.size() / (1024.0 * 1024.0) / (ms / 1000.0));
+
+    for (const std::string &path: paths) {
+        ok = ok && std::filesystem::file_size(path) == writes * chunk.size();
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(dir);
+
+    for (int i = 0; i < 500; i++) ok = ok && spawn("sleep(20);");
+    start = Clock::now();
+    ok = ok && loop.run();
+    metrics.emplace_back("timers_500x20ms_ms", elapsedMs(start));
+
+    for (int i = 0; i < 20; i++) ok = ok && spawn("exec(\"sleep 0.05\");");
+    start = Clock::now();
+    ok = ok && loop.run();
+    metrics.emplace_back("exec_20x50ms_ms", elapsedMs(start));
+
+    return ok;
+}
+
+// literal parsing and number formatting against the libc routines they replace,
+// then compiling a source that is mostly number literals
+static bool numberConversions(Metrics &metrics) {
+    std::vector<std::string> literals;
+    for (int i = 0; i < 1000000; i++) {
+        // a mix of integers and fractions like the ones scripts contain
+        literals.push_back(i % 3 == 0 ? std::to_string(i) : std::to_string(i / 1000) + "." + std::to_string(i % 997));
+    }
+
+    double sum = 0;
+    Clock::time_point start = Clock::now();
+    for (const std::string &literal: literals) {
+        sum += strtod(literal.c_str(), nullptr);
+    }
+    metrics.emplace_back("strtod_ms", elapsedMs(start));
+
+    double fastSum = 0;
+    bool ok = true;
+    start = Clock::now();
+    for (const std::string &literal: literals) {
+        double number = 0;
+        ok = parseNumber(literal.data(), static_cast<int>(literal.size()), number) && ok;
+        fastSum += number;
+    }
+    metrics.emplace_back("parse_ms", elapsedMs(start));
+    ok = ok && sum == fastSum;
+
+    char buffer[NUMBER_MAX_LENGTH];
+    size_t length = 0;
+    start = Clock::now();
+    for (int i = 0; i < 1000000; i++) {
+        length += snprintf(buffer, sizeof(buffer), "%.17g", i / 7.0);
+    }
+    metrics.emplace_back("snprintf_ms", elapsedMs(start));
+
+    start = Clock::now();
+    for (int i = 0; i < 1000000; i++) {
+        length += formatNumber(i / 7.0, buffer);
+    }
+    metrics.emplace_back("format_ms", elapsedMs(start));
+
+    // one chunk only has room for 256 constants
+    std::string source = "{ var x = 0;\n";
+    for (int i = 0; i < 250; i++) {
+        source += "x = x + " + std::to_string(i) + "." + std::to_string(i * 37 % 1000) + ";\n";
+    }
+    source += "print x; }\n";
+    start = Clock::now();
+    for (int i = 0; i < 2000; i++) {
+        VM vm;
+        ok = ok && vm.compile(source.c_str()) != nullptr;
+    }
+    metrics.emplace_back("compile_literals_ms", elapsedMs(start));
+
+    return ok && length > 0;
+}
+
+// a host running the same small script over and over, compiling it every time against compiling once
+// and reusing the vm, then calling a script function directly
+static bool embedding(Metrics &metrics) {
+    const int runs = 100000;
+    std::string source = "var y = x * 2 + 1;";
+
+    VM vm;
+    vm.setJitEnabled(options.jit);
+    bool ok = true;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        vm.setGlobal("x", Value(static_cast<double>(i)));
+        ok = ok && vm.interpret(source.c_str()) == VM::InterpretResult::Ok;
+    }
+    metrics.emplace_back("interpret_source_ns", elapsedMs(start) * 1e6 / runs);
+
+    ObjFunction *script = vm.compile(source.c_str());
+    if (script == nullptr) return false;
+    Value y;
+    start = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        vm.setGlobal("x", Value(static_cast<double>(i)));
+        ok = ok && vm.interpret(script) == VM::InterpretResult::Ok;
+        ok = ok && vm.getGlobal("y", y) && y.asNumber() == i * 2 + 1;
+    }
+    metrics.emplace_back("interpret_compiled_ns", elapsedMs(start) * 1e6 / runs);
+
+    ok = ok && vm.interpret("fun f(a, b) { return a * b + 1; }") == VM::InterpretResult::Ok;
+    Value f;
+    ok = ok && vm.getGlobal("f", f);
+    start = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        Value args[]{Value(static_cast<double>(i)), Value(2.0)};
+        ok = ok && vm.call(f, 2, args, &y) == VM::InterpretResult::Ok && y.asNumber() == i * 2 + 1;
+    }
+    metrics.emplace_back("call_ns", elapsedMs(start) * 1e6 / runs);
+    return ok;
+}
+
+// building a million entry table one set at a time against pre-sizing it and against one bulk insert
+static bool tableBuild(Metrics &metrics) {
+    const int count = 1000000;
+    std::vector<Value> pairs;
+    for (int i = 0; i < count; i++) {
+        pairs.emplace_back(static_cast<double>(i) * 1.5);
+        pairs.emplace_back(static_cast<double>(i));
+    }
+
+    Table grown;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; i++) {
+        grown.set(pairs[2 * i], pairs[2 * i + 1]);
+    }
+    metrics.emplace_back("grown_ms", elapsedMs(start));
+
+    Table reserved;
+    start = Clock::now();
+    reserved.reserve(count);
+    for (int i = 0; i < count; i++) {
+        reserved.set(pairs[2 * i], pairs[2 * i + 1]);
+    }
+    metrics.emplace_back("reserved_ms", elapsedMs(start));
+
+    Table bulk;
+    start = Clock::now();
+    bulk.setAll(pairs.data(), count);
+    metrics.emplace_back("bulk_ms", elapsedMs(start));
+
+    Value value;
+    return grown.size() == count && reserved.size() == count && bulk.size() == count &&
+           bulk.get(pairs[2 * (count - 1)], &value) && value.asNumber() == count - 1;
+}
+
+// splitting 100k csv records into fields and summing one column, on slices as split returns them
+// and again with every field copied into an interned string first
+static bool textRecords(Metrics &metrics) {
+    std::string text;
+    for (int i = 0; i < 100000; i++) {
+        text += "record" + std::to_string(i) + "," + std::to_string(i % 977) + ",host" + std::to_string(i % 13)
+                + ",GET /index.html\n";
+    }
+
+    // lox has no escapes, the separator is a newline inside the string literal
+    auto run = [&](const char *fields, const char *metric) {
+        VM vm;
+        vm.setJitEnabled(options.jit);
+        vm.output().setSink([](const char *, size_t) {});
+        vm.setGlobal("text", Value(vm, text.data(), static_cast<int>(text.size())));
+        std::string source = "var lines = split(text, \"\n\"); var total = 0;"
+                             "for (var i = 0; i < len(lines) - 1; i = i + 1) {"
+                             "  var fields = " + std::string(fields) + ";"
+                             "  total = total + num(fields[1]);"
+                             "}";
+        Clock::time_point start = Clock::now();
+        bool ok = vm.interpret(source.c_str()) == VM::InterpretResult::Ok;
+        metrics.emplace_back(metric, elapsedMs(start));
+        Value total;
+        return ok && vm.getGlobal("total", total) && total.isNumber();
+    };
+
+    bool ok = run("split(lines[i], \",\")", "slices_ms");
+    ok = run("split(tostring(lines[i]), \",\"); for (var f = 0; f < 4; f = f + 1) fields[f] = tostring(fields[f])",
+             "copies_ms") && ok;
+    return ok;
+}
+
+// formatting 2000 log lines into one string by concatenation and through a string builder,
+// also counting how many strings each way leaves in the intern table
+static bool logFormat(Metrics &metrics) {
+    auto run = [&](const char *start, const char *append, const char *finish, const char *prefix) {
+        VM vm;
+        vm.setJitEnabled(options.jit);
+        vm.output().setSink([](const char *, size_t) {});
+        int before = vm.strings().size();
+        // the line break is a newline inside the string literal
+        std::string source = std::string("var levels = [\"INFO\", \"WARN\", \"DEBUG\"]; ") + start +
+                             "for (var i = 0; i < 2000; i = i + 1) {"
+                             "  var level = levels[i % 3];"
+                             "  " + append + ";"
+                             "}"
+                             "var log = " + finish + ";";
+        Clock::time_point begin = Clock::now();
+        bool ok = vm.interpret(source.c_str()) == VM::InterpretResult::Ok;
+        metrics.emplace_back(std::string(prefix) + "_ms", elapsedMs(begin));
+        metrics.emplace_back(std::string(prefix) + "_interned", vm.strings().size() - before);
+        Value log;
+        return ok && vm.getGlobal("log", log) && log.isString() && log.asString()->length() > 2000 * 30;
+    };
+
+    bool ok = run("var s = \"\";",
+                  "s = s + \"[\" + level + \"] request \" + tostring(i) + \" served in \" + tostring(i / 8) + \" ms\n\"",
+                  "s", "concat");
+    ok = run("var b = builder();",
+             "append(b, \"[\", level, \"] request \", i, \" served in \", i / 8, \" ms\n\")",
+             "tostring(b)", "builder") && ok;
+    return ok;
+}
+
+// 200k lines glued together from short pieces and printed once, so none of them is needed as a key
+static bool transientStrings(Metrics &metrics) {
+    VM vm;
+    vm.setJitEnabled(options.jit);
+    vm.output().setSink([](const char *, size_t) {});
+    int before = vm.strings().size();
+    const char *source = "var user = \"user\"; var sep = \": \";"
+                         "for (var i = 0; i < 200000; i = i + 1) {"
+                         "  print user + tostring(i) + sep + \"logged in from \" + \"10.0.0.\" + tostring(i % 250);"
+                         "}";
+    Clock::time_point start = Clock::now();
+    bool ok = vm.interpret(source) == VM::InterpretResult::Ok;
+    metrics.emplace_back("ms", elapsedMs(start));
+    metrics.emplace_back("interned", vm.strings().size() - before);
+    return ok;
+}
+
+static double residentKb() {
+    long pages = 0;
+    long resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return static_cast<double>(resident * sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// a million typed lines through one repl session, resident memory is sampled after the first
+// tenth and at the end, then the same lines as separate scripts for comparison
+static bool replSession(Metrics &metrics) {
+    const int lines = 1000000;
+    const char *typed[]{
+            "x = x + 1;",
+            "if (x > 3) { var t = x * 2; t = t - 1; }",
+            "print x;",
+            "print twice(x) + 1;",
+    };
+    const int kinds = sizeof(typed) / sizeof(typed[0]);
+
+    auto session = [&](const std::function<VM::InterpretResult(const char *)> &interpret, const char *prefix) {
+        // there is no collector yet, a function declared over and over would pile up either way
+        bool ok = interpret("var x = 0;") == VM::InterpretResult::Ok;
+        ok = ok && interpret("fun twice(n) { return n * 2; }") == VM::InterpretResult::Ok;
+        double warm = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < lines; i++) {
+            ok = ok && interpret(typed[i % kinds]) == VM::InterpretResult::Ok;
+            if (i == lines / 10) warm = residentKb();
+        }
+        metrics.emplace_back(std::string(prefix) + "_ns_per_line", elapsedMs(start) * 1e6 / lines);
+        metrics.emplace_back(std::string(prefix) + "_rss_growth_kb", residentKb() - warm);
+        return ok;
+    };
+
+    bool ok;
+    {
+        VM vm;
+        vm.setJitEnabled(options.jit);
+        vm.output().setSink([](const char *, size_t) {});
+        Repl repl(vm);
+        ok = session([&](const char *line) { return repl.interpret(line); }, "repl");
+    }
+    {
+        VM vm;
+        vm.setJitEnabled(options.jit);
+        vm.output().setSink([](const char *, size_t) {});
+        ok = session([&](const char *line) { return vm.interpret(line); }, "interpret") && ok;
+    }
+    return ok;
+}
+
+// threads interning overlapping identifiers, shared lock-free space against one table behind a mutex
+static bool internThroughput(Metrics &metrics) {
+    const int words = 50000;
+    const int passes = 4;
+    std::vector<std::string> identifiers;
+    for (int i = 0; i < words; i++) {
+        identifiers.push_back("identifier_" + std::to_string(i));
+    }
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    int maxThreads = std::max(cores, 4);
+
+    auto measure = [&](int threads, const std::function<void(const std::string &)> &intern) {
+        std::vector<std::thread> workers;
+        Clock::time_point start = Clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                // each thread starts at a different word so inserts race on different buckets first
+                for (int pass = 0; pass < passes; pass++) {
+                    for (int i = 0; i < words; i++) {
+                        intern(identifiers[(i + t * words / threads) % words]);
+                    }
+                }
+            });
+        }
+        for (std::thread &worker: workers) worker.join();
+        return static_cast<double>(threads) * words * passes / (elapsedMs(start) / 1000.0);
+    };
+
+    bool ok = true;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::string prefix = "threads_" + std::to_string(threads);
+
+        StringSpace space(words);
+        metrics.emplace_back(prefix + "_shared_per_s", measure(threads, [&space](const std::string &word) {
+            space.intern(word.data(), static_cast<int>(word.size()));
+        }));
+        ok = ok && space.count() == words;
+
+        VM vm;
+        std::mutex mutex;
+        metrics.emplace_back(prefix + "_locked_per_s", measure(threads, [&](const std::string &word) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ObjString::create(vm, word.data(), static_cast<int>(word.size()));
+        }));
+    }
+    return ok;
+}
+
+static std::vector<Benchmark> benchmarks() {
+    std::vector<Benchmark> result;
+
+    std::vector<std::filesystem::path> scripts;
+    for (const auto &entry: std::filesystem::directory_iterator(CPPLOX_BENCH_SCRIPTS)) {
+        if (entry.path().extension() == ".lox") scripts.push_back(entry.path());
+    }
+    std::sort(scripts.begin(), scripts.end());
+    for (const auto &path: scripts) {
+        result.push_back(scriptBenchmark(path.stem().string(), [path] { return readFile(path.string()); }));
+    }
+
+    result.push_back(scriptBenchmark("primes", [] { return readFile(CPPLOX_SOURCE_DIR "/test.lox"); }));
+    result.push_back(scriptBenchmark("deep_nesting", [] { return generateDeepNesting(100, 2000); }));
+    result.push_back(scriptBenchmark("large_source", [] { return generateLargeSource(20000); }));
+    result.push_back({"pool_scaling", poolScaling, nullptr});
+    result.push_back({"shared_code", sharedCode, nullptr});
+    result.push_back({"intern_throughput", internThroughput, nullptr});
+    result.push_back({"parallel_compile", parallelCompile, nullptr});
+    result.push_back({"fiber_switch", fiberSwitch, nullptr});
+    result.push_back({"time_slicing", timeSlicing, nullptr});
+    result.push_back({"event_loop_io", eventLoopIo, nullptr});
+    result.push_back({"number_conversions", numberConversions, nullptr});
+    result.push_back({"embedding", embedding, nullptr});
+    result.push_back({"repl_session", replSession, nullptr});
+    result.push_back({"table_build", tableBuild, nullptr});
+    result.push_back({"text_records", textRecords, nullptr});
+    result.push_back({"log_format", logFormat, nullptr});
+    result.push_back({"transient_strings", transientStrings, nullptr});
+    result.push_back({"compile_locals", compileLocals, nullptr});
+    result.push_back({"ir_pipeline", irPipeline, nullptr});
+
+    return result;
+}
+
+static bool runInChild(const std::function<bool(Metrics &)> &body, Metrics &metrics) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+
+    if (pid == 0) {
+        close(fds[0]);
+
+        // scripts print, keep the report on stdout clean
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+
+        Metrics childMetrics;
+        bool ok = body(childMetrics);
+        fflush(stdout);
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        childMetrics.emplace_back("peak_rss_kb", static_cast<double>(usage.ru_maxrss));
+
+        FILE *out = fdopen(fds[1], "w");
+        for (const auto &[key, value]: childMetrics) {
+            fprintf(out, "%s %.17g\n", key.c_str(), value);
+        }
+        fclose(out);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    FILE *in = fdopen(fds[0], "r");
+    char key[128];
+    double value;
+    while (fscanf(in, "%127s %lf", key, &value) == 2) {
+        metrics.emplace_back(key, value);
+    }
+    fclose(in);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+// one json object per line, metrics are medians over the repeats
+static void report(const Benchmark &benchmark) {
+    bool ok = true;
+    std::vector<Metrics> runs(options.repeat);
+    for (Metrics &metrics: runs) {
+        ok = runInChild(benchmark.run, metrics) && ok;
+    }
+
+    Metrics result;
+    for (const auto &[key, value]: runs[0]) {
+        std::vector<double> values;
+        for (const Metrics &metrics: runs) {
+            for (const auto &[otherKey, otherValue]: metrics) {
+                if (otherKey == key) values.push_back(otherValue);
+            }
+        }
+        result.emplace_back(key, median(values));
+    }
+
+    if (benchmark.count) {
+        Metrics counted;
+        ok = runInChild(benchmark.count, counted) && ok;
+        for (const auto &entry: counted) {
+            if (entry.first != "peak_rss_kb") result.push_back(entry);
+        }
+    }
+
+    printf(R"({"benchmark":"%s","status":"%s","jit":%s,"repeat":%d)", benchmark.name.c_str(),
+           ok ? "ok" : "error", options.jit ? "true" : "false", options.repeat);
+    for (const auto &[key, value]: result) {
+        if (value == static_cast<double>(static_cast<long long>(value))) {
+            printf(R"(,"%s":%lld)", key.c_str(), static_cast<long long>(value));
+        } else {
+            printf(R"(,"%s":%.6g)", key.c_str(), value);
+        }
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+static void usage() {
+    fprintf(stderr, "Usage cpplox_bench [--jit] [--repeat=N] [--filter=substring] [--list]\n");
+    exit(64);
+}
+
+int main(int argc, const char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--jit") == 0) {
+            options.jit = true;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            options.list = true;
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            options.repeat = atoi(argv[i] + 9);
+            if (options.repeat < 1) usage();
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            options.filter = argv[i] + 9;
+        } else {
+            usage();
+        }
+    }
+
+    for (const Benchmark &benchmark: benchmarks()) {
+        if (options.filter != nullptr && benchmark.name.find(options.filter) == std::string::npos) continue;
+        if (options.list) {
+            printf("%s\n", benchmark.name.c_str());
+        } else {
+            report(benchmark);
+        }
+    }
+    return 0;
+}
@@ -16,6 +16,12 @@ void Chunk::patch(int offset, uint8_t byte) {
     _code[offset] = byte;
 }
 
+void Chunk::clear() {
+    _code.clear();
+    _lines.clear();
+    _constants.clear();
+}
+
 int Chunk::addConstant(Value value) {
     int index = static_cast<int>(_constants.size());
     _constants.push_back(value);
@@ -26,109 +32,370 @@ Value Chunk::getConstant(uint8_t index) {
     return _constants[index];
 }
 
-void Chunk::disassemble(const char *name) const {
-    printf("== %s ==\n", name);
+static bool isJump(OpCode opCode) {
+    switch (opCode) {
+        case OpCode::Jump:
+        case OpCode::JumpIfTrue:
+        case OpCode::JumpIfFalse:
+        case OpCode::PopJumpIfFalse:
+        case OpCode::Loop:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Chunk::simplifyJumps() {
+    // targets are instruction indices while rewriting, a dropped instruction's targets fall through to the next live one
+    struct Instruction {
+        int offset;
+        OpCode op;
+        int target;
+        bool live;
+    };
+
+    std::vector<Instruction> code;
+    std::vector<int> index(_code.size() + 1, -1);
+    for (int offset = 0; offset < count(); offset += instructionSize(static_cast<OpCode>(_code[offset]))) {
+        index[offset] = static_cast<int>(code.size());
+        code.push_back({offset, static_cast<OpCode>(_code[offset]), -1, true});
+    }
+    int end = static_cast<int>(code.size());
+    index[count()] = end;
+    for (Instruction &instruction: code) {
+        if (!isJump(instruction.op)) continue;
+        int jump = (_code[instruction.offset + 1] << 8) | _code[instruction.offset + 2];
+        int next = instruction.offset + 3;
+        instruction.target = index[instruction.op == OpCode::Loop ? next - jump : next + jump];
+    }
+
+    auto resolve = [&](int i) {
+        while (i < end && !code[i].live) i++;
+        return i;
+    };
+
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        // a jump landing on a jump whose outcome is already known goes straight on from there
+        for (int i = 0; i < end; i++) {
+            Instruction &jump = code[i];
+            if (!jump.live || !isJump(jump.op) || jump.op == OpCode::Loop) continue;
+
+            int target = resolve(jump.target);
+            while (target < end) {
+                const Instruction &at = code[target];
+                int next;
+                if (at.op == OpCode::Jump) {
+                    next = at.target;
+                } else if ((jump.op == OpCode::JumpIfFalse || jump.op == OpCode::JumpIfTrue) && at.op == jump.op) {
+                    next = at.target;
+                } else if ((jump.op == OpCode::JumpIfFalse && at.op == OpCode::JumpIfTrue) ||
+                           (jump.op == OpCode::JumpIfTrue && at.op == OpCode::JumpIfFalse)) {
+                    next = target + 1;
+                } else if (jump.op == OpCode::Jump && at.op == OpCode::Loop &&
+                           code[resolve(at.target)].offset <= jump.offset) {
+                    // the loop's budget check moves along with it
+                    jump.op = OpCode::Loop;
+                    target = resolve(at.target);
+                    break;
+                } else {
+                    break;
+                }
+
+                next = resolve(next);
+                // offsets only shrink from here, so a hop in range now stays in range
+                if (next <= target || next == end || code[next].offset - jump.offset - 3 > UINT16_MAX) break;
+                target = next;
+            }
+
+            if (target != jump.target) {
+                jump.target = target;
+                changed = true;
+            }
+        }
+
+        std::vector<bool> targeted(end + 1, false);
+        for (const Instruction &instruction: code) {
+            if (instruction.live && isJump(instruction.op)) targeted[resolve(instruction.target)] = true;
+        }
+
+        // if and while pop the condition right after the JumpIfFalse and again where it lands
+        for (int i = 0; i < end; i++) {
+            Instruction &jump = code[i];
+            if (!jump.live || jump.op != OpCode::JumpIfFalse) continue;
+            int pop = resolve(i + 1);
+            int target = resolve(jump.target);
+            if (pop == end || target == end || pop == target || targeted[pop]) continue;
+            if (code[pop].op != OpCode::Pop || code[target].op != OpCode::Pop) continue;
+
+            jump.op = OpCode::PopJumpIfFalse;
+            jump.target = target + 1;
+            code[pop].live = false;
+            changed = true;
+        }
+
+        // the nil return every chunk ends with stays, the parallel linker cuts it off each piece
+        std::vector<bool> reached(end, false);
+        std::vector<int> worklist{0};
+        if (end >= 2) worklist.push_back(end - 2);
+        while (!worklist.empty()) {
+            int i = resolve(worklist.back());
+            worklist.pop_back();
+            if (i == end || reached[i]) continue;
+            reached[i] = true;
+
+            const Instruction &instruction = code[i];
+            if (isJump(instruction.op)) worklist.push_back(instruction.target);
+            if (instruction.op != OpCode::Jump && instruction.op != OpCode::Loop && instruction.op != OpCode::Return) {
+                worklist.push_back(i + 1);
+            }
+        }
+        for (int i = 0; i < end; i++) {
+            if (code[i].live && !reached[i]) {
+                code[i].live = false;
+                changed = true;
+            }
+        }
+
+        for (int i = 0; i < end; i++) {
+            Instruction &jump = code[i];
+            if (!jump.live || !isJump(jump.op) || jump.op == OpCode::Loop) continue;
+            if (resolve(jump.target) != resolve(i + 1)) continue;
+
+            if (jump.op == OpCode::PopJumpIfFalse) {
+                jump.op = OpCode::Pop;
+            } else {
+                jump.live = false;
+            }
+            changed = true;
+        }
+    }
+
+    std::vector<int> offsets(end + 1);
+    int offset = 0;
+    for (int i = 0; i < end; i++) {
+        offsets[i] = offset;
+        if (code[i].live) offset += instructionSize(code[i].op);
+    }
+    offsets[end] = offset;
+
+    std::vector<uint8_t> rewritten;
+    std::vector<int> lines;
+    rewritten.reserve(offset);
+    lines.reserve(offset);
+    for (int i = 0; i < end; i++) {
+        const Instruction &instruction = code[i];
+        if (!instruction.live) continue;
+        int line = _lines[instruction.offset];
+
+        rewritten.push_back(static_cast<uint8_t>(instruction.op));
+        lines.push_back(line);
+        if (isJump(instruction.op)) {
+            int next = offsets[i] + 3;
+            int target = offsets[resolve(instruction.target)];
+            int jump = instruction.op == OpCode::Loop ? next - target : target - next;
+            rewritten.push_back((jump >> 8) & 0xFF);
+            rewritten.push_back(jump & 0xFF);
+            lines.push_back(line);
+            lines.push_back(line);
+        } else {
+            for (int byte = 1; byte < instructionSize(instruction.op); byte++) {
+                rewritten.push_back(_code[instruction.offset + byte]);
+                lines.push_back(_lines[instruction.offset + byte]);
+            }
+        }
+    }
+    _code.swap(rewritten);
+    _lines.swap(lines);
+}
+
+int Chunk::instructionSize(OpCode opCode) {
+    switch (opCode) {
+        case OpCode::Constant:
+        case OpCode::GetLocal:
+        case OpCode::SetLocal:
+        case OpCode::GetGlobal:
+        case OpCode::DefineGlobal:
+        case OpCode::SetGlobal:
+        case OpCode::Call:
+        case OpCode::BuildList:
+        case OpCode::BuildMap:
+            return 2;
+        case OpCode::Jump:
+        case OpCode::JumpIfTrue:
+        case OpCode::JumpIfFalse:
+        case OpCode::PopJumpIfFalse:
+        case OpCode::Loop:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+OpCode Chunk::genericForm(OpCode opCode) {
+    switch (opCode) {
+        case OpCode::AddNumber:
+        case OpCode::ConcatString:
+            return OpCode::Add;
+        case OpCode::SubtractNumber:
+            return OpCode::Subtract;
+        case OpCode::MultiplyNumber:
+            return OpCode::Multiply;
+        case OpCode::DivideNumber:
+            return OpCode::Divide;
+        case OpCode::ModuloNumber:
+            return OpCode::Modulo;
+        case OpCode::GreaterNumber:
+            return OpCode::Greater;
+        case OpCode::GreaterEqualNumber:
+            return OpCode::GreaterEqual;
+        case OpCode::LessNumber:
+            return OpCode::Less;
+        case OpCode::LessEqualNumber:
+            return OpCode::LessEqual;
+        default:
+            return opCode;
+    }
+}
+
+void Chunk::disassemble(const char *name, FILE *out) const {
+    fprintf(out, "== %s ==\n", name);
     int offset = 0;
     while (offset < _code.size()) {
-        offset = disassembleInstruction(offset);
+        offset = disassembleInstruction(offset, out);
     }
 }
 
-int Chunk::disassembleInstruction(int offset) const {
-    printf("%04d ", offset);
+int Chunk::disassembleInstruction(int offset, FILE *out) const {
+    fprintf(out, "%04d ", offset);
     if (offset > 0 && _lines[offset] == _lines[offset - 1]) {
-        printf("   | ");
+        fprintf(out, "   | ");
     } else {
-        printf("%4d ", _lines[offset]);
+        fprintf(out, "%4d ", _lines[offset]);
     }
     auto instruction = static_cast<OpCode>(_code[offset]);
     switch (instruction) {
         case OpCode::Constant:
-            return constantInstruction("OP_CONSTANT", offset);
+            return constantInstruction("OP_CONSTANT", offset, out);
         case OpCode::Nil:
-            return simpleInstruction("OP_NIL", offset);
+            return simpleInstruction("OP_NIL", offset, out);
         case OpCode::True:
-            return simpleInstruction("OP_TRUE", offset);
+            return simpleInstruction("OP_TRUE", offset, out);
         case OpCode::False:
-            return simpleInstruction("OP_FALSE", offset);
+            return simpleInstruction("OP_FALSE", offset, out);
         case OpCode::Pop:
-            return simpleInstruction("OP_POP", offset);
+            return simpleInstruction("OP_POP", offset, out);
         case OpCode::GetLocal:
-            return byteInstruction("OP_GET_LOCAL", offset);
+            return byteInstruction("OP_GET_LOCAL", offset, out);
         case OpCode::SetLocal:
-            return byteInstruction("OP_SET_LOCAL", offset);
+            return byteInstruction("OP_SET_LOCAL", offset, out);
         case OpCode::GetGlobal:
-            return constantInstruction("OP_GET_GLOBAL", offset);
+            return constantInstruction("OP_GET_GLOBAL", offset, out);
         case OpCode::DefineGlobal:
-            return constantInstruction("OP_DEFINE_GLOBAL", offset);
+            return constantInstruction("OP_DEFINE_GLOBAL", offset, out);
         case OpCode::SetGlobal:
-            return constantInstruction("OP_SET_GLOBAL", offset);
+            return constantInstruction("OP_SET_GLOBAL", offset, out);
         case OpCode::Equal:
-            return simpleInstruction("OP_EQUAL", offset);
+            return simpleInstruction("OP_EQUAL", offset, out);
         case OpCode::NotEqual:
-            return simpleInstruction("OP_NOT_EQUAL", offset);
+            return simpleInstruction("OP_NOT_EQUAL", offset, out);
         case OpCode::Greater:
-            return simpleInstruction("OP_GREATER", offset);
+            return simpleInstruction("OP_GREATER", offset, out);
         case OpCode::GreaterEqual:
-            return simpleInstruction("OP_GREATER_EQUAL", offset);
+            return simpleInstruction("OP_GREATER_EQUAL", offset, out);
         case OpCode::Less:
-            return simpleInstruction("OP_LESS", offset);
+            return simpleInstruction("OP_LESS", offset, out);
         case OpCode::LessEqual:
-            return simpleInstruction("OP_LESS_EQUAL", offset);
+            return simpleInstruction("OP_LESS_EQUAL", offset, out);
         case OpCode::Add:
-            return simpleInstruction("OP_ADD", offset);
+            return simpleInstruction("OP_ADD", offset, out);
         case OpCode::Subtract:
-            return simpleInstruction("OP_SUBTRACT", offset);
+            return simpleInstruction("OP_SUBTRACT", offset, out);
         case OpCode::Multiply:
-            return simpleInstruction("OP_MULTIPLY", offset);
+            return simpleInstruction("OP_MULTIPLY", offset, out);
         case OpCode::Divide:
-            return simpleInstruction("OP_DIVIDE", offset);
+            return simpleInstruction("OP_DIVIDE", offset, out);
         case OpCode::Modulo:
-            return simpleInstruction("OP_MODULO", offset);
+            return simpleInstruction("OP_MODULO", offset, out);
         case OpCode::Not:
-            return simpleInstruction("OP_NOT", offset);
+            return simpleInstruction("OP_NOT", offset, out);
         case OpCode::Negate:
-            return simpleInstruction("OP_NEGATE", offset);
+            return simpleInstruction("OP_NEGATE", offset, out);
         case OpCode::Print:
-            return simpleInstruction("OP_PRINT", offset);
+            return simpleInstruction("OP_PRINT", offset, out);
         case OpCode::Jump:
-            return jumpInstruction("OP_JUMP", 1, offset);
+            return jumpInstruction("OP_JUMP", 1, offset, out);
         case OpCode::JumpIfTrue:
-            return jumpInstruction("OP_JUMP_IF_TRUE", 1, offset);
+            return jumpInstruction("OP_JUMP_IF_TRUE", 1, offset, out);
         case OpCode::JumpIfFalse:
-            return jumpInstruction("OP_JUMP_IF_FALSE", 1, offset);
+            return jumpInstruction("OP_JUMP_IF_FALSE", 1, offset, out);
+        case OpCode::PopJumpIfFalse:
+            return jumpInstruction("OP_POP_JUMP_IF_FALSE", 1, offset, out);
         case OpCode::Loop:
-            return jumpInstruction("OP_LOOP", -1, offset);
+            return jumpInstruction("OP_LOOP", -1, offset, out);
+        case OpCode::Call:
+            return byteInstruction("OP_CALL", offset, out);
         case OpCode::Return:
-            return simpleInstruction("OP_RETURN", offset);
+            return simpleInstruction("OP_RETURN", offset, out);
+        case OpCode::Yield:
+            return simpleInstruction("OP_YIELD", offset, out);
+        case OpCode::BuildList:
+            return byteInstruction("OP_BUILD_LIST", offset, out);
+        case OpCode::BuildMap:
+            return byteInstruction("OP_BUILD_MAP", offset, out);
+        case OpCode::GetIndex:
+            return simpleInstruction("OP_GET_INDEX", offset, out);
+        case OpCode::SetIndex:
+            return simpleInstruction("OP_SET_INDEX", offset, out);
+        case OpCode::AddNumber:
+            return simpleInstruction("OP_ADD_NUMBER", offset, out);
+        case OpCode::ConcatString:
+            return simpleInstruction("OP_CONCAT_STRING", offset, out);
+        case OpCode::SubtractNumber:
+            return simpleInstruction("OP_SUBTRACT_NUMBER", offset, out);
+        case OpCode::MultiplyNumber:
+            return simpleInstruction("OP_MULTIPLY_NUMBER", offset, out);
+        case OpCode::DivideNumber:
+            return simpleInstruction("OP_DIVIDE_NUMBER", offset, out);
+        case OpCode::ModuloNumber:
+            return simpleInstruction("OP_MODULO_NUMBER", offset, out);
+        case OpCode::GreaterNumber:
+            return simpleInstruction("OP_GREATER_NUMBER", offset, out);
+        case OpCode::GreaterEqualNumber:
+            return simpleInstruction("OP_GREATER_EQUAL_NUMBER", offset, out);
+        case OpCode::LessNumber:
+            return simpleInstruction("OP_LESS_NUMBER", offset, out);
+        case OpCode::LessEqualNumber:
+            return simpleInstruction("OP_LESS_EQUAL_NUMBER", offset, out);
         default:
-            printf("Unknown op code %d\n", instruction);
+            fprintf(out, "Unknown op code %d\n", instruction);
             return offset + 1;
     }
 }
 
-int Chunk::simpleInstruction(const char *name, int offset) {
-    printf("%s\n", name);
+int Chunk::simpleInstruction(const char *name, int offset, FILE *out) {
+    fprintf(out, "%s\n", name);
     return offset + 1;
 }
 
-int Chunk::byteInstruction(const char *name, int offset) const {
+int Chunk::byteInstruction(const char *name, int offset, FILE *out) const {
     uint8_t slot = _code[offset + 1];
-    printf("%-16s %4d\n", name, slot);
+    fprintf(out, "%-16s %4d\n", name, slot);
     return offset + 2;
 }
 
-int Chunk::jumpInstruction(const char *name, int sign, int offset) const {
+int Chunk::jumpInstruction(const char *name, int sign, int offset, FILE *out) const {
     auto jump = (uint16_t) (_code[offset + 1] << 8);
     jump |= _code[offset + 2];
-    printf("%-16s %4d -> %d\n", name, offset, offset + 3 + sign * jump);
+    fprintf(out, "%-16s %4d -> %d\n", name, offset, offset + 3 + sign * jump);
     return offset + 3;
 }
 
-int Chunk::constantInstruction(const char *name, int offset) const {
+int Chunk::constantInstruction(const char *name, int offset, FILE *out) const {
     uint8_t constant = _code[offset + 1];
-    printf("%-16s %4d '", name, constant);
-    _constants[constant].print();
-    printf("'\n");
+    fprintf(out, "%-16s %4d '", name, constant);
+    _constants[constant].print(out);
+    fprintf(out, "'\n");
     return offset + 2;
 }
@@ -5,8 +5,11 @@
 #ifndef CPPLOX_CHUNK_H
 #define CPPLOX_CHUNK_H
 
+#include <cstdint>
+#include <cstdio>
 #include <vector>
 
+#include "forward.h"
 #include "value.h"
 
 class Chunk {
@@ -15,28 +18,46 @@ public:
 
     void patch(int offset, uint8_t byte);
 
+    // empties the chunk but keeps its storage for the next round of writes
+    void clear();
+
     int addConstant(Value value);
 
+    // threads jumps to their final target, fuses JumpIfFalse and the Pops on both of its paths,
+    // drops unreachable code and jumps to the next instruction, then rewrites the offsets
+    void simplifyJumps();
+
     Value getConstant(uint8_t index);
 
+    [[nodiscard]] const Value *constants() const { return _constants.data(); }
+
+    [[nodiscard]] int constantCount() const { return static_cast<int>(_constants.size()); }
+
     [[nodiscard]] const uint8_t *code() const { return _code.data(); }
 
+    // writable view for in-place quickening
+    [[nodiscard]] uint8_t *code() { return _code.data(); }
+
     [[nodiscard]] int count() const { return static_cast<int>(_code.size()); }
 
     [[nodiscard]] int getInstructionLine(int instruction) const { return _lines[instruction]; }
 
-    void disassemble(const char *name) const;
+    static int instructionSize(OpCode opCode);
+
+    static OpCode genericForm(OpCode opCode);
+
+    void disassemble(const char *name, FILE *out = stdout) const;
 
-    int disassembleInstruction(int offset) const; // NOLINT(modernize-use-nodiscard)
+    int disassembleInstruction(int offset, FILE *out = stdout) const; // NOLINT(modernize-use-nodiscard)
 
 private:
-    static int simpleInstruction(const char *name, int offset);
+    static int simpleInstruction(const char *name, int offset, FILE *out);
 
-    [[nodiscard]] int byteInstruction(const char *name, int offset) const;
+    [[nodiscard]] int byteInstruction(const char *name, int offset, FILE *out) const;
 
-    [[nodiscard]] int jumpInstruction(const char *name, int sign, int offset) const;
+    [[nodiscard]] int jumpInstruction(const char *name, int sign, int offset, FILE *out) const;
 
-    [[nodiscard]] int constantInstruction(const char *name, int offset) const;
+    [[nodiscard]] int constantInstruction(const char *name, int offset, FILE *out) const;
 
     std::vector<uint8_t> _code;
     std::vector<int> _lines;
@@ -0,0 +1,75 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "code_object.h"
+
+#include "jit.h"
+#include "object.h"
+#include "op_code.h"
+
+std::shared_ptr<const CodeObject> CodeObject::freeze(const ObjFunction *function,
+                                                     std::shared_ptr<StringSpace> strings, bool jit) {
+    if (strings == nullptr) strings = std::make_shared<StringSpace>();
+
+    std::shared_ptr<CodeObject> code(new CodeObject);
+    code->_strings = std::move(strings);
+    code->_function = code->freezeFunction(function, jit);
+    if (code->_function == nullptr) return nullptr;
+
+    return code;
+}
+
+bool CodeObject::shareConstant(Value &value, bool jit) { // NOLINT(misc-no-recursion)
+    if (!value.isObj()) return true;
+
+    if (value.isFunction()) {
+        ObjFunction *frozen = freezeFunction(value.asFunction(), jit);
+        if (frozen == nullptr) return false;
+        value = Value(frozen);
+        return true;
+    }
+    if (!value.isString()) return false;
+
+    const ObjString *string = value.asString();
+    value = Value(_strings->intern(string->chars(), string->length()));
+    return true;
+}
+
+ObjFunction *CodeObject::freezeFunction(const ObjFunction *function, bool jit) { // NOLINT(misc-no-recursion)
+    auto frozen = new ObjFunction;
+    _functions.push_back(frozen);
+    frozen->frozen = true;
+    frozen->arity = function->arity;
+    if (function->name != nullptr) {
+        frozen->name = _strings->intern(function->name->chars(), function->name->length());
+    }
+
+    const Chunk &chunk = function->chunk;
+    for (int i = 0; i < chunk.constantCount(); i++) {
+        Value constant = chunk.constants()[i];
+        if (!shareConstant(constant, jit)) return nullptr;
+        frozen->chunk.addConstant(constant);
+    }
+
+    int offset = 0;
+    while (offset < chunk.count()) {
+        auto opCode = static_cast<OpCode>(chunk.code()[offset]);
+        int size = Chunk::instructionSize(opCode);
+        frozen->chunk.write(static_cast<uint8_t>(Chunk::genericForm(opCode)), chunk.getInstructionLine(offset));
+        for (int i = 1; i < size; i++) {
+            frozen->chunk.write(chunk.code()[offset + i], chunk.getInstructionLine(offset + i));
+        }
+        offset += size;
+    }
+
+    if (jit) frozen->jitCode = JitCode::compile(frozen->chunk, frozen->arity);
+
+    return frozen;
+}
+
+CodeObject::~CodeObject() {
+    for (ObjFunction *function: _functions) {
+        delete function;
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_CODE_OBJECT_H
+#define CPPLOX_CODE_OBJECT_H
+
+#include <memory>
+#include <vector>
+
+#include "forward.h"
+#include "non_copyable.h"
+#include "string_space.h"
+
+// compiled code frozen for sharing, any number of vms on any threads may run it at once
+class CodeObject : NonCopyable {
+public:
+    // copies function and the functions it declares with their constants moved into strings (a fresh space if none is given),
+    // quickened instructions are reset and jit code is compiled up front if asked for,
+    // returns nullptr if a constant is an object that can't be shared
+    static std::shared_ptr<const CodeObject> freeze(const ObjFunction *function,
+                                                    std::shared_ptr<StringSpace> strings = nullptr,
+                                                    bool jit = false);
+
+    ~CodeObject();
+
+    [[nodiscard]] inline ObjFunction *function() const { return _function; }
+
+    [[nodiscard]] inline const std::shared_ptr<StringSpace> &strings() const { return _strings; }
+
+private:
+    CodeObject() = default;
+
+    ObjFunction *freezeFunction(const ObjFunction *function, bool jit);
+
+    bool shareConstant(Value &value, bool jit);
+
+    ObjFunction *_function = nullptr;
+    // the script and every function declared in it
+    std::vector<ObjFunction *> _functions;
+    std::shared_ptr<StringSpace> _strings;
+};
+
+#endif //CPPLOX_CODE_OBJECT_H
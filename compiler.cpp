@@ -7,10 +7,18 @@
 #include "chunk.h"
 #include "op_code.h"
 #include "value.h"
+#include "vm.h"
 
-ObjFunction *Compiler::compile(const char *source) {
-    _parser.init(source);
-    CompilerContext context(FunctionType::Script);
+ObjFunction *Compiler::compile(const char *source, int line) {
+    CompilerContext context(_vm, FunctionType::Script);
+    return compile(source, context, line);
+}
+
+ObjFunction *Compiler::compile(const char *source, CompilerContext &context, int line) {
+    _parser.init(source, _vm.errorStream(), line);
+    _loopStart = -1;
+    _loopScopeDepth = 0;
+    _loopBreakJumps.clear();
     beginCompile(&context);
 
     advance();
@@ -50,6 +58,7 @@ int Compiler::emitJump(OpCode instruction) {
 }
 
 void Compiler::emitReturn() {
+    emitByte(OpCode::Nil);
     emitByte(OpCode::Return);
 }
 
@@ -84,11 +93,12 @@ void Compiler::beginCompile(CompilerContext *context) {
 ObjFunction *Compiler::endCompile() {
     emitReturn();
     ObjFunction *function = _current->function();
+    if (!hadError()) currentChunk().simplifyJumps();
 
 #ifdef DEBUG_PRINT_CODE
     if (!hadError()) {
         ObjString *name = function->name;
-        currentChunk().disassemble(name != nullptr ? name->chars() : "<script>");
+        currentChunk().disassemble(name != nullptr ? name->chars() : "<script>", _vm.outputStream());
     }
 #endif
 
@@ -150,6 +160,71 @@ void Compiler::binary(bool) {
     }
 }
 
+uint8_t Compiler::argumentList() { // NOLINT(misc-no-recursion)
+    uint8_t argCount = 0;
+    if (!check(TokenType::RightParen)) {
+        do {
+            expression();
+            if (argCount == 255) {
+                error("Can't have more than 255 arguments.");
+            }
+            argCount++;
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightParen, "Expect ')' after arguments.");
+    return argCount;
+}
+
+void Compiler::call(bool) { // NOLINT(misc-no-recursion)
+    uint8_t argCount = argumentList();
+    emitBytes(OpCode::Call, argCount);
+}
+
+void Compiler::listLiteral(bool) { // NOLINT(misc-no-recursion)
+    uint8_t count = 0;
+    if (!check(TokenType::RightBracket)) {
+        do {
+            expression();
+            if (count == 255) {
+                error("Can't have more than 255 elements in a list literal.");
+            }
+            count++;
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightBracket, "Expect ']' after list elements.");
+    emitBytes(OpCode::BuildList, count);
+}
+
+// a '{' where an expression is expected can't start a block
+void Compiler::mapLiteral(bool) { // NOLINT(misc-no-recursion)
+    uint8_t count = 0;
+    if (!check(TokenType::RightBrace)) {
+        do {
+            expression();
+            consume(TokenType::Colon, "Expect ':' after map key.");
+            expression();
+            if (count == 255) {
+                error("Can't have more than 255 entries in a map literal.");
+            }
+            count++;
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightBrace, "Expect '}' after map entries.");
+    emitBytes(OpCode::BuildMap, count);
+}
+
+void Compiler::subscript(bool canAssign) { // NOLINT(misc-no-recursion)
+    expression();
+    consume(TokenType::RightBracket, "Expect ']' after index.");
+
+    if (canAssign && match(TokenType::Equal)) {
+        expression();
+        emitByte(OpCode::SetIndex);
+    } else {
+        emitByte(OpCode::GetIndex);
+    }
+}
+
 void Compiler::literal(bool) {
     switch (_parser.previous().type) {
         case TokenType::False:
@@ -176,7 +251,7 @@ void Compiler::number(bool) {
 }
 
 void Compiler::string(bool) {
-    emitConstant(_parser.string());
+    emitConstant(_parser.string(_vm));
 }
 
 void Compiler::namedVariable(Token name, bool canAssign) {
@@ -229,10 +304,13 @@ void Compiler::unary(bool) {
 
 const Compiler::ParseRule *Compiler::getRule(TokenType type) {
     static const ParseRule RULES[]{
-            {&Compiler::grouping, nullptr,               Precedence::None}, //left paren
+            {&Compiler::grouping, &Compiler::call,       Precedence::Call}, //left paren
             {nullptr,             nullptr,               Precedence::None}, // right paren
-            {nullptr,             nullptr,               Precedence::None}, // left brace
+            {&Compiler::mapLiteral, nullptr,             Precedence::None}, // left brace
             {nullptr,             nullptr,               Precedence::None}, // right brace
+            {&Compiler::listLiteral, &Compiler::subscript, Precedence::Call}, // left bracket
+            {nullptr,             nullptr,               Precedence::None}, // right bracket
+            {nullptr,             nullptr,               Precedence::None}, // colon
             {nullptr,             nullptr,               Precedence::None}, // comma
             {nullptr,             nullptr,               Precedence::None}, // dot
             {&Compiler::unary,    &Compiler::binary,     Precedence::Term}, // minus
@@ -270,6 +348,7 @@ const Compiler::ParseRule *Compiler::getRule(TokenType type) {
             {&Compiler::literal,  nullptr,               Precedence::None}, // true
             {nullptr,             nullptr,               Precedence::None}, // var
             {nullptr,             nullptr,               Precedence::None}, // while
+            {nullptr,             nullptr,               Precedence::None}, // yield
             {nullptr,             nullptr,               Precedence::None}, // error
             {nullptr,             nullptr,               Precedence::None}, // eof
     };
@@ -299,7 +378,8 @@ void Compiler::parsePrecedence(Precedence precedence) {
 }
 
 uint8_t Compiler::identifierConstant(const Token &name) {
-    return makeConstant(Value(name.start, name.length));
+    // names stay objects whatever their length, globals and error messages want an ObjString
+    return makeConstant(Value(ObjString::create(_vm, name.start, name.length)));
 }
 
 void Compiler::addLocal(const Token &name) {
@@ -362,6 +442,53 @@ void Compiler::block() { // NOLINT(misc-no-recursion)
     consume(TokenType::RightBrace, "Expect '}' after block.");
 }
 
+void Compiler::function(FunctionType type) { // NOLINT(misc-no-recursion)
+    CompilerContext *enclosing = _current;
+    CompilerContext context(_vm, type);
+    beginCompile(&context);
+    const Token &name = _parser.previous();
+    _current->function()->name = ObjString::create(_vm, name.start, name.length);
+
+    // loops don't reach into the function body
+    int loopStart = _loopStart;
+    int loopScopeDepth = _loopScopeDepth;
+    std::vector<int> loopBreakJumps = std::move(_loopBreakJumps);
+    _loopStart = -1;
+    _loopScopeDepth = 0;
+
+    beginScope();
+    consume(TokenType::LeftParen, "Expect '(' after function name.");
+    if (!check(TokenType::RightParen)) {
+        do {
+            _current->function()->arity++;
+            if (_current->function()->arity > 255) {
+                error("Can't have more than 255 parameters.");
+            }
+            uint8_t constant = parseVariable("Expect parameter name.");
+            defineVariable(constant);
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightParen, "Expect ')' after parameters.");
+    consume(TokenType::LeftBrace, "Expect '{' before function body.");
+    block();
+
+    ObjFunction *function = endCompile();
+    _current = enclosing;
+    _loopStart = loopStart;
+    _loopScopeDepth = loopScopeDepth;
+    _loopBreakJumps = std::move(loopBreakJumps);
+
+    emitConstant(Value(function));
+}
+
+void Compiler::funDeclaration() { // NOLINT(misc-no-recursion)
+    uint8_t global = parseVariable("Expect function name.");
+    // a function may refer to itself
+    if (!_current->inGlobalScope()) _current->markLastLocalInitialized();
+    function(FunctionType::Function);
+    defineVariable(global);
+}
+
 void Compiler::varDeclaration() {
     uint8_t global = parseVariable("Expect variable name.");
 
@@ -492,6 +619,20 @@ void Compiler::printStatement() {
     emitByte(OpCode::Print);
 }
 
+void Compiler::returnStatement() {
+    if (_current->type() == FunctionType::Script) {
+        error("Can't return from top-level code.");
+    }
+
+    if (match(TokenType::Semicolon)) {
+        emitReturn();
+    } else {
+        expression();
+        consume(TokenType::Semicolon, "Expect ';' after return value.");
+        emitByte(OpCode::Return);
+    }
+}
+
 void Compiler::whileStatement() { // NOLINT(misc-no-recursion)
     beginScope();
 
@@ -524,6 +665,16 @@ void Compiler::whileStatement() { // NOLINT(misc-no-recursion)
     }
 }
 
+void Compiler::yieldStatement() {
+    if (match(TokenType::Semicolon)) {
+        emitByte(OpCode::Nil);
+    } else {
+        expression();
+        consume(TokenType::Semicolon, "Expect ';' after yield value.");
+    }
+    emitByte(OpCode::Yield);
+}
+
 void Compiler::statement() { // NOLINT(misc-no-recursion)
     if (match(TokenType::Print)) {
         printStatement();
@@ -535,8 +686,12 @@ void Compiler::statement() { // NOLINT(misc-no-recursion)
         forStatement();
     } else if (match(TokenType::If)) {
         ifStatement();
+    } else if (match(TokenType::Return)) {
+        returnStatement();
     } else if (match(TokenType::While)) {
         whileStatement();
+    } else if (match(TokenType::Yield)) {
+        yieldStatement();
     } else if (match(TokenType::LeftBrace)) {
         beginScope();
         block();
@@ -547,7 +702,9 @@ void Compiler::statement() { // NOLINT(misc-no-recursion)
 }
 
 void Compiler::declaration() { // NOLINT(misc-no-recursion)
-    if (match(TokenType::Var)) {
+    if (match(TokenType::Fun)) {
+        funDeclaration();
+    } else if (match(TokenType::Var)) {
         varDeclaration();
     } else {
         statement();
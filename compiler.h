@@ -13,7 +13,12 @@
 
 class Compiler {
 public:
-    ObjFunction *compile(const char *source);
+    explicit Compiler(VM &vm) : _vm(vm) {}
+
+    ObjFunction *compile(const char *source, int line = 1);
+
+    // compiles into context's function instead of a new one
+    ObjFunction *compile(const char *source, CompilerContext &context, int line = 1);
 
 private:
     inline void advance() { _parser.advance(); }
@@ -58,6 +63,16 @@ private:
 
     void binary(bool canAssign);
 
+    uint8_t argumentList();
+
+    void call(bool canAssign);
+
+    void listLiteral(bool canAssign);
+
+    void mapLiteral(bool canAssign);
+
+    void subscript(bool canAssign);
+
     void literal(bool canAssign);
 
     void grouping(bool canAssign);
@@ -106,6 +121,10 @@ private:
 
     void block();
 
+    void function(FunctionType type);
+
+    void funDeclaration();
+
     void varDeclaration();
 
     void expressionStatement();
@@ -120,12 +139,17 @@ private:
 
     void printStatement();
 
+    void returnStatement();
+
     void whileStatement();
 
+    void yieldStatement();
+
     void statement();
 
     void declaration();
 
+    VM &_vm;
     Parser _parser;
     CompilerContext *_current = nullptr;
 
@@ -4,15 +4,26 @@
 
 #include "compiler_context.h"
 
+#include "jit.h"
 #include "object.h"
 
-CompilerContext::CompilerContext(FunctionType type)
+CompilerContext::CompilerContext(VM &vm, FunctionType type)
         : _type(type) {
-    _function = new ObjFunction;
+    _function = new ObjFunction(vm);
 
-    // reserve stack slot 0
+    // reserve stack slot 0, it has no name to be found by
     Local &local = _locals[_localsCount++];
     local.name.start = "";
+    clearIndex();
+}
+
+void CompilerContext::reset() {
+    _function->chunk.clear();
+    delete _function->jitCode;
+    _function->jitCode = nullptr;
+    _localsCount = 1;
+    _scopeDepth = 0;
+    clearIndex();
 }
 
 void CompilerContext::beginScope() {
@@ -21,7 +32,10 @@ void CompilerContext::beginScope() {
 
 int CompilerContext::endScope() {
     int numLocalsToDiscard = numLocalsTill(_scopeDepth - 1);
-    _localsCount -= numLocalsToDiscard;
+    for (int i = 0; i < numLocalsToDiscard; i++) {
+        const Local &local = _locals[--_localsCount];
+        _buckets[local.hash % UINT8_COUNT] = local.next;
+    }
     _scopeDepth--;
     return numLocalsToDiscard;
 }
@@ -29,39 +43,32 @@ int CompilerContext::endScope() {
 bool CompilerContext::addLocal(const Token &name) {
     if (_localsCount == UINT8_COUNT) return false;
 
-    Local &local = _locals[_localsCount++];
+    int index = _localsCount++;
+    Local &local = _locals[index];
     local.name = name;
     local.depth = -1;
+    local.hash = hash(name);
+
+    int &bucket = _buckets[local.hash % UINT8_COUNT];
+    local.next = bucket;
+    bucket = index;
 
     return true;
 }
 
 bool CompilerContext::hasLocal(const Token &name) const {
-    for (int i = _localsCount - 1; i >= 0; i--) {
-        const Local &local = _locals[i];
-        if (local.depth != -1 && local.depth < _scopeDepth) {
-            break;
-        }
-        if (name.lexemeEqual(local.name)) {
-            return true;
-        }
-    }
-    return false;
+    int index = find(name);
+    if (index == -1) return false;
+    const Local &local = _locals[index];
+    return local.depth == -1 || local.depth >= _scopeDepth;
 }
 
 CompilerContext::ResolveResult CompilerContext::resolveLocal(const Token &name, int &slot) const {
-    for (int i = _localsCount - 1; i >= 0; i--) {
-        const Local &local = _locals[i];
-        if (name.lexemeEqual(local.name)) {
-            if (local.depth == -1) {
-                return ResolveResult::Uninitialized;
-            } else {
-                slot = i;
-                return ResolveResult::Local;
-            }
-        }
-    }
-    return ResolveResult::Global;
+    int index = find(name);
+    if (index == -1) return ResolveResult::Global;
+    if (_locals[index].depth == -1) return ResolveResult::Uninitialized;
+    slot = index;
+    return ResolveResult::Local;
 }
 
 int CompilerContext::numLocalsTill(int targetDepth) {
@@ -71,3 +78,25 @@ int CompilerContext::numLocalsTill(int targetDepth) {
     }
     return count;
 }
+
+uint32_t CompilerContext::hash(const Token &name) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < name.length; i++) {
+        hash ^= static_cast<uint8_t>(name.start[i]);
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+int CompilerContext::find(const Token &name) const {
+    uint32_t h = hash(name);
+    for (int i = _buckets[h % UINT8_COUNT]; i != -1; i = _locals[i].next) {
+        const Local &local = _locals[i];
+        if (local.hash == h && name.lexemeEqual(local.name)) return i;
+    }
+    return -1;
+}
+
+void CompilerContext::clearIndex() {
+    _buckets.fill(-1);
+}
@@ -6,6 +6,7 @@
 #define CPPLOX_COMPILER_CONTEXT_H
 
 #include <array>
+#include <cstdint>
 
 #include "forward.h"
 #include "token.h"
@@ -17,10 +18,15 @@ enum class FunctionType {
 
 class CompilerContext {
 public:
-    explicit CompilerContext(FunctionType type);
+    CompilerContext(VM &vm, FunctionType type);
+
+    // back to an empty top level with function's chunk cleared, for compiling into it again
+    void reset();
 
     ObjFunction *function() { return _function; }
 
+    [[nodiscard]] inline FunctionType type() const { return _type; }
+
     void beginScope();
 
     int endScope();
@@ -31,6 +37,9 @@ public:
 
     bool addLocal(const Token &name);
 
+    // the newest local lives in slot localCount() - 1
+    [[nodiscard]] inline int localCount() const { return _localsCount; }
+
     [[nodiscard]] bool hasLocal(const Token &name) const;
 
     enum class ResolveResult {
@@ -51,13 +60,26 @@ private:
     struct Local {
         Token name;
         int depth = 0;
+        uint32_t hash = 0;
+        // the next older local in the same bucket, or -1
+        int next = -1;
     };
 
+    static uint32_t hash(const Token &name);
+
+    // innermost local called name, or -1
+    [[nodiscard]] int find(const Token &name) const;
+
+    void clearIndex();
+
     ObjFunction *_function = nullptr;
     FunctionType _type;
 
     std::array<Local, UINT8_COUNT> _locals;
     int _localsCount = 0;
+    // chains of locals by name hash, newest first, so shadowing falls out of the order and
+    // locals leave their bucket in the reverse order they joined it
+    std::array<int, UINT8_COUNT> _buckets;
     int _scopeDepth = 0;
 };
 
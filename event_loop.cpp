@@ -0,0 +1,305 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "event_loop.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "number.h"
+#include "object.h"
+
+extern char **environ;
+
+static constexpr int READ_CHUNK = 16384;
+
+// longer sleeps are cut to this, about 24 days, the longest timeout poll takes
+static constexpr double SLEEP_MAX_MS = INT_MAX;
+
+static bool checkArguments(VM &vm, const char *name, int argCount, int expected) {
+    if (argCount == expected) return true;
+    vm.runtimeError("%s() expects %d arguments but got %d.", name, expected, argCount);
+    return false;
+}
+
+static bool checkFd(VM &vm, const char *name, const Value &value) {
+    if (value.isNumber() && fitsInt(value.asNumber()) && value.asNumber() >= 0) return true;
+    vm.runtimeError("%s() expects a file descriptor number.", name);
+    return false;
+}
+
+static bool checkString(VM &vm, const char *name, const Value &value) {
+    if (value.isText()) return true;
+    vm.runtimeError("%s() expects a string.", name);
+    return false;
+}
+
+EventLoop::EventLoop(VM &vm) : _vm(vm) {
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+
+    vm.defineNative("open", openNative, this);
+    vm.defineNative("read", readNative, this);
+    vm.defineNative("write", writeNative, this);
+    vm.defineNative("close", closeNative, this);
+    vm.defineNative("sleep", sleepNative, this);
+    vm.defineNative("exec", execNative, this);
+}
+
+EventLoop::~EventLoop() {
+    for (auto &[fd, waiter]: _waiters) {
+        release(fd, waiter, true);
+    }
+    ::close(_epoll);
+}
+
+Fiber &EventLoop::spawn(ObjFunction *function) {
+    _fibers.push_back(_vm.spawn(function));
+    _runnable.push_back(_fibers.back().get());
+    return *_fibers.back();
+}
+
+bool EventLoop::run() {
+    bool ok = true;
+    while (!_runnable.empty() || !_waiters.empty()) {
+        // one turn for every fiber that was runnable when the pass started
+        for (size_t i = _runnable.size(); i > 0; i--) {
+            Fiber *fiber = _runnable.front();
+            _runnable.pop_front();
+            switch (_vm.resume(*fiber, _slice)) {
+                case VM::InterpretResult::Yielded:
+                case VM::InterpretResult::Suspended:
+                    _runnable.push_back(fiber);
+                    break;
+                case VM::InterpretResult::Blocked:
+                case VM::InterpretResult::Ok:
+                    break;
+                default:
+                    ok = false;
+                    break;
+            }
+        }
+
+        if (!_waiters.empty()) poll(_runnable.empty());
+    }
+
+    _fibers.clear();
+    return ok;
+}
+
+NativeResult EventLoop::wait(int fd, Waiter waiter, Value *args) {
+    if (complete(fd, waiter)) {
+        release(fd, waiter, false);
+        args[-1] = waiter.result;
+        return NativeResult::Ok;
+    }
+
+    short events = waiter.operation == Operation::Write ? POLLOUT : POLLIN;
+    waiter.fiber = _vm.currentFiber();
+    // only the fiber's resumer can continue a script's fiber, parking it would hand it to the loop
+    if (waiter.fiber == nullptr || waiter.fiber->nested()) {
+        pollfd ready{fd, events, 0};
+        do {
+            ::poll(&ready, 1, -1);
+        } while (!complete(fd, waiter));
+        release(fd, waiter, false);
+        args[-1] = waiter.result;
+        return NativeResult::Ok;
+    }
+
+    if (_waiters.count(fd) != 0) {
+        _vm.runtimeError("File descriptor %d already has an operation pending.", fd);
+        release(fd, waiter, false);
+        return NativeResult::Error;
+    }
+
+    epoll_event event{};
+    event.events = waiter.operation == Operation::Write ? EPOLLOUT : EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        _vm.runtimeError("Can't wait on file descriptor %d: %s.", fd, strerror(errno));
+        release(fd, waiter, false);
+        return NativeResult::Error;
+    }
+    _waiters.emplace(fd, std::move(waiter));
+    return NativeResult::Block;
+}
+
+bool EventLoop::complete(int fd, Waiter &waiter) {
+    char buffer[READ_CHUNK];
+    switch (waiter.operation) {
+        case Operation::Read: {
+            ssize_t count = ::read(fd, buffer, sizeof(buffer));
+            if (count < 0 && errno == EAGAIN) return false;
+            waiter.result = count > 0 ? Value(_vm, buffer, static_cast<int>(count)) : Value();
+            return true;
+        }
+        case Operation::Write: {
+            while (waiter.written < waiter.data.size()) {
+                ssize_t count = ::write(fd, waiter.data.data() + waiter.written, waiter.data.size() - waiter.written);
+                if (count < 0 && errno == EAGAIN) return false;
+                if (count < 0) {
+                    waiter.result = Value();
+                    return true;
+                }
+                waiter.written += count;
+            }
+            waiter.result = Value(static_cast<double>(waiter.written));
+            return true;
+        }
+        case Operation::Timer: {
+            uint64_t expirations;
+            if (::read(fd, &expirations, sizeof(expirations)) < 0 && errno == EAGAIN) return false;
+            waiter.result = Value();
+            return true;
+        }
+        case Operation::Exec: {
+            while (true) {
+                ssize_t count = ::read(fd, buffer, sizeof(buffer));
+                if (count < 0 && errno == EAGAIN) return false;
+                if (count <= 0) break;
+                waiter.data.append(buffer, count);
+            }
+            waiter.result = Value(_vm, waiter.data.data(), static_cast<int>(waiter.data.size()));
+            return true;
+        }
+    }
+    return true;
+}
+
+void EventLoop::release(int fd, const Waiter &waiter, bool registered) {
+    if (registered) epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    if (waiter.operation == Operation::Timer || waiter.operation == Operation::Exec) ::close(fd);
+    if (waiter.pid > 0) waitpid(waiter.pid, nullptr, 0);
+}
+
+void EventLoop::poll(bool block) {
+    epoll_event events[64];
+    int count = epoll_wait(_epoll, events, 64, block ? -1 : 0);
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        auto it = _waiters.find(fd);
+        if (it == _waiters.end() || !complete(fd, it->second)) continue;
+
+        Waiter waiter = std::move(it->second);
+        _waiters.erase(it);
+        release(fd, waiter, true);
+        waiter.fiber->deliver(waiter.result);
+        _runnable.push_back(waiter.fiber);
+    }
+}
+
+NativeResult EventLoop::openNative(VM &vm, void *, int argCount, Value *args) {
+    if (!checkArguments(vm, "open", argCount, 2)) return NativeResult::Error;
+    if (!checkString(vm, "open", args[0]) || !checkString(vm, "open", args[1])) return NativeResult::Error;
+
+    std::string_view mode = args[1].asText();
+    int flags;
+    if (mode == "r") {
+        flags = O_RDONLY;
+    } else if (mode == "w") {
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+    } else if (mode == "a") {
+        flags = O_WRONLY | O_CREAT | O_APPEND;
+    } else {
+        vm.runtimeError("open() mode must be \"r\", \"w\" or \"a\".");
+        return NativeResult::Error;
+    }
+
+    std::string path(args[0].asText());
+    int fd = ::open(path.c_str(), flags | O_NONBLOCK | O_CLOEXEC, 0644);
+    args[-1] = fd < 0 ? Value() : Value(static_cast<double>(fd));
+    return NativeResult::Ok;
+}
+
+NativeResult EventLoop::readNative(VM &vm, void *data, int argCount, Value *args) {
+    if (!checkArguments(vm, "read", argCount, 1) || !checkFd(vm, "read", args[0])) return NativeResult::Error;
+
+    Waiter waiter;
+    waiter.operation = Operation::Read;
+    return static_cast<EventLoop *>(data)->wait(static_cast<int>(args[0].asNumber()), std::move(waiter), args);
+}
+
+NativeResult EventLoop::writeNative(VM &vm, void *data, int argCount, Value *args) {
+    if (!checkArguments(vm, "write", argCount, 2) || !checkFd(vm, "write", args[0])) return NativeResult::Error;
+    if (!checkString(vm, "write", args[1])) return NativeResult::Error;
+
+    Waiter waiter;
+    waiter.operation = Operation::Write;
+    waiter.data.assign(args[1].asText());
+    return static_cast<EventLoop *>(data)->wait(static_cast<int>(args[0].asNumber()), std::move(waiter), args);
+}
+
+NativeResult EventLoop::closeNative(VM &vm, void *, int argCount, Value *args) {
+    if (!checkArguments(vm, "close", argCount, 1) || !checkFd(vm, "close", args[0])) return NativeResult::Error;
+
+    ::close(static_cast<int>(args[0].asNumber()));
+    args[-1] = Value();
+    return NativeResult::Ok;
+}
+
+NativeResult EventLoop::sleepNative(VM &vm, void *data, int argCount, Value *args) {
+    if (!checkArguments(vm, "sleep", argCount, 1)) return NativeResult::Error;
+    // nan fails the comparison too
+    if (!args[0].isNumber() || !(args[0].asNumber() >= 0)) {
+        vm.runtimeError("sleep() expects a number of milliseconds that isn't negative.");
+        return NativeResult::Error;
+    }
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    auto nanoseconds = static_cast<int64_t>(std::min(args[0].asNumber(), SLEEP_MAX_MS) * 1e6);
+    itimerspec spec{};
+    // a zero timeout would disarm the timer, round up to the next nanosecond
+    if (nanoseconds < 1) nanoseconds = 1;
+    spec.it_value.tv_sec = nanoseconds / 1000000000;
+    spec.it_value.tv_nsec = nanoseconds % 1000000000;
+    timerfd_settime(fd, 0, &spec, nullptr);
+
+    Waiter waiter;
+    waiter.operation = Operation::Timer;
+    return static_cast<EventLoop *>(data)->wait(fd, std::move(waiter), args);
+}
+
+NativeResult EventLoop::execNative(VM &vm, void *data, int argCount, Value *args) {
+    if (!checkArguments(vm, "exec", argCount, 1) || !checkString(vm, "exec", args[0])) return NativeResult::Error;
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        vm.runtimeError("exec() can't create a pipe: %s.", strerror(errno));
+        return NativeResult::Error;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+    char shell[] = "/bin/sh";
+    char flag[] = "-c";
+    std::string command(args[0].asText());
+    char *argv[]{shell, flag, command.data(), nullptr};
+    pid_t pid;
+    int error = posix_spawn(&pid, shell, &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(fds[1]);
+    if (error != 0) {
+        ::close(fds[0]);
+        vm.runtimeError("exec() can't start the shell: %s.", strerror(error));
+        return NativeResult::Error;
+    }
+
+    Waiter waiter;
+    waiter.operation = Operation::Exec;
+    waiter.pid = pid;
+    return static_cast<EventLoop *>(data)->wait(fds[0], std::move(waiter), args);
+}
@@ -0,0 +1,95 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_EVENT_LOOP_H
+#define CPPLOX_EVENT_LOOP_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+#include "non_copyable.h"
+#include "vm.h"
+
+// runs fibers of one vm on one thread, a fiber calling an i/o native parks until epoll says the fd is ready
+// linux only, natives it registers:
+//   open(path, mode) -> fd or nil, mode is "r", "w" or "a"
+//   read(fd) -> next chunk of data as a string, nil at end of file
+//   write(fd, string) -> number of bytes written
+//   close(fd)
+//   sleep(ms)
+//   exec(command) -> everything the shell command wrote to stdout, once it has exited
+// outside of a fiber, or in one a script resumed, the same natives simply block
+class EventLoop : NonCopyable {
+public:
+    explicit EventLoop(VM &vm);
+
+    ~EventLoop();
+
+    // the loop owns the fiber, it's freed once run returns
+    Fiber &spawn(ObjFunction *function);
+
+    // runs until every fiber has finished, false if any of them failed
+    bool run();
+
+    // backward jumps a fiber may take before the others get a turn
+    inline void setSlice(int64_t slice) { _slice = slice; }
+
+    [[nodiscard]] inline int pending() const { return static_cast<int>(_waiters.size()); }
+
+private:
+    enum class Operation {
+        Read,
+        Write,
+        Timer,
+        Exec,
+    };
+
+    struct Waiter {
+        Fiber *fiber = nullptr;
+        Operation operation = Operation::Read;
+        // bytes to write, or output collected so far for exec
+        std::string data;
+        size_t written = 0;
+        pid_t pid = -1;
+        Value result;
+    };
+
+    static NativeResult openNative(VM &vm, void *data, int argCount, Value *args);
+
+    static NativeResult readNative(VM &vm, void *data, int argCount, Value *args);
+
+    static NativeResult writeNative(VM &vm, void *data, int argCount, Value *args);
+
+    static NativeResult closeNative(VM &vm, void *data, int argCount, Value *args);
+
+    static NativeResult sleepNative(VM &vm, void *data, int argCount, Value *args);
+
+    static NativeResult execNative(VM &vm, void *data, int argCount, Value *args);
+
+    // tries the operation right away, then parks the current fiber on fd,
+    // or blocks right here when there is no fiber to park
+    NativeResult wait(int fd, Waiter waiter, Value *args);
+
+    // retries the operation, true once waiter.result is set
+    bool complete(int fd, Waiter &waiter);
+
+    // timer and process fds belong to the operation and are closed with it
+    void release(int fd, const Waiter &waiter, bool registered);
+
+    void poll(bool block);
+
+    VM &_vm;
+    int _epoll = -1;
+    int64_t _slice = 10000;
+    std::vector<std::unique_ptr<Fiber>> _fibers;
+    std::deque<Fiber *> _runnable;
+    std::unordered_map<int, Waiter> _waiters;
+};
+
+#endif //CPPLOX_EVENT_LOOP_H
@@ -5,12 +5,28 @@
 #ifndef CPPLOX_FORWARD_H
 #define CPPLOX_FORWARD_H
 
+class Fiber;
+
+class JitCode;
+
 enum class ObjType;
 
 struct Obj;
 
 struct ObjFunction;
 
+class ObjFiber;
+
+class ObjList;
+
+struct ObjMap;
+
+class ObjSlice;
+
+class ObjStringBuilder;
+
+struct ObjNative;
+
 class ObjString;
 
 enum class OpCode;
@@ -19,4 +35,8 @@ enum class TokenType;
 
 struct Token;
 
+class Value;
+
+class VM;
+
 #endif //CPPLOX_FORWARD_H
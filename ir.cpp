@@ -0,0 +1,29 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "ir.h"
+
+IrArena::~IrArena() {
+    for (char *block: _blocks) {
+        delete[] block;
+    }
+}
+
+void *IrArena::allocate(size_t size, size_t align) {
+    _bytes += size;
+    if (size > BLOCK_SIZE) {
+        // lists longer than a block get one of their own, the next allocation starts a fresh block
+        _blocks.push_back(new char[size]);
+        _used = BLOCK_SIZE;
+        return _blocks.back();
+    }
+
+    size_t offset = (_used + align - 1) & ~(align - 1);
+    if (offset + size > BLOCK_SIZE) {
+        _blocks.push_back(new char[BLOCK_SIZE]);
+        offset = 0;
+    }
+    _used = offset + size;
+    return _blocks.back() + offset;
+}
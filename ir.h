@@ -0,0 +1,154 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_IR_H
+#define CPPLOX_IR_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "forward.h"
+#include "non_copyable.h"
+#include "op_code.h"
+#include "value.h"
+
+// a fixed run of items in the arena, passes may shrink it but never grow it
+template<typename T>
+struct IrList {
+    T *items = nullptr;
+    int count = 0;
+
+    [[nodiscard]] inline T *begin() const { return items; }
+
+    [[nodiscard]] inline T *end() const { return items + count; }
+};
+
+// bump allocator the ir lives in, freed in one go once the code is lowered
+class IrArena : NonCopyable {
+public:
+    IrArena() = default;
+
+    ~IrArena();
+
+    template<typename T>
+    T *make() {
+        static_assert(std::is_trivially_destructible_v<T>, "the arena never runs destructors");
+        return new(allocate(sizeof(T), alignof(T))) T();
+    }
+
+    template<typename T>
+    IrList<T> list(const std::vector<T> &items) {
+        IrList<T> list;
+        list.count = static_cast<int>(items.size());
+        if (list.count == 0) return list;
+        list.items = static_cast<T *>(allocate(sizeof(T) * items.size(), alignof(T)));
+        for (int i = 0; i < list.count; i++) {
+            new(list.items + i) T(items[i]);
+        }
+        return list;
+    }
+
+    [[nodiscard]] inline size_t bytes() const { return _bytes; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    void *allocate(size_t size, size_t align);
+
+    std::vector<char *> _blocks;
+    size_t _used = BLOCK_SIZE;
+    size_t _bytes = 0;
+};
+
+struct IrFunction;
+
+enum class IrExprKind {
+    Constant,
+    GetLocal,
+    SetLocal,
+    GetGlobal,
+    SetGlobal,
+    Unary,
+    Binary,
+    And,
+    Or,
+    Call,
+    List,
+    Map,
+    GetIndex,
+    SetIndex,
+    Function,
+};
+
+// one node type for every expression, so a pass can rewrite a node in place
+struct IrExpr {
+    IrExprKind kind = IrExprKind::Constant;
+    // the line the direct compiler would have emitted the instruction on
+    int line = 0;
+    // Unary and Binary
+    OpCode op = OpCode::Nil;
+    // locals, local is the declaration's id within its function or -1 for parameters
+    int slot = 0;
+    int local = -1;
+    // Constant, or the name of a global
+    Value value;
+    // operand, left and right, callee, or target, index and assigned value
+    IrExpr *a = nullptr;
+    IrExpr *b = nullptr;
+    IrExpr *c = nullptr;
+    // arguments, list elements, or map keys and values alternating
+    IrList<IrExpr *> items;
+    IrFunction *function = nullptr;
+};
+
+enum class IrStmtKind {
+    Expression,
+    Print,
+    DefineGlobal,
+    DefineLocal,
+    Block,
+    If,
+    Loop,
+    Break,
+    Continue,
+    Return,
+    Yield,
+};
+
+struct IrStmt {
+    IrStmtKind kind = IrStmtKind::Expression;
+    int line = 0;
+    // the value, or a condition, null for a bare return or yield and a loop without condition
+    IrExpr *expr = nullptr;
+    // a loop's increment
+    IrExpr *increment = nullptr;
+    // DefineGlobal's name, DefineLocal's id
+    Value name;
+    int local = -1;
+    // locals a block or loop scope drops at its end, or break and continue drop before jumping
+    int pops = 0;
+    // a loop's initializer
+    IrStmt *init = nullptr;
+    // an if's then branch or a loop's body
+    IrStmt *body = nullptr;
+    IrStmt *otherwise = nullptr;
+    IrList<IrStmt *> stmts;
+};
+
+struct IrFunction {
+    // named and given its arity while parsing, lowering fills in the chunk
+    ObjFunction *function = nullptr;
+    IrList<IrStmt *> body;
+    // the functions declared directly in this one, so passes reach them without walking the body
+    IrList<IrFunction *> functions;
+    // local ids handed out to declarations
+    int locals = 0;
+    // where the implicit return at the end goes
+    int line = 0;
+};
+
+#endif //CPPLOX_IR_H
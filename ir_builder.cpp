@@ -0,0 +1,599 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "ir_builder.h"
+
+#include "object.h"
+#include "vm.h"
+
+IrFunction *IrBuilder::build(const char *source, int line) {
+    _parser.init(source, _vm.errorStream(), line);
+    _loopScopeDepth = -1;
+
+    FunctionState state(_vm, FunctionType::Script);
+    _function = &state;
+
+    advance();
+
+    auto function = _arena.make<IrFunction>();
+    function->function = context().function();
+    function->body = declarations(TokenType::Eof);
+    function->functions = _arena.list(state.functions);
+    function->locals = state.locals;
+    function->line = _parser.previous().line;
+    _function = nullptr;
+
+    return _parser.hadError() ? nullptr : function;
+}
+
+IrExpr *IrBuilder::expr(IrExprKind kind) {
+    auto expr = _arena.make<IrExpr>();
+    expr->kind = kind;
+    expr->line = _parser.previous().line;
+    return expr;
+}
+
+IrStmt *IrBuilder::stmt(IrStmtKind kind) {
+    auto stmt = _arena.make<IrStmt>();
+    stmt->kind = kind;
+    stmt->line = _parser.previous().line;
+    return stmt;
+}
+
+IrExpr *IrBuilder::constant(Value value) {
+    IrExpr *constant = expr(IrExprKind::Constant);
+    constant->value = value;
+    return constant;
+}
+
+const IrBuilder::ParseRule *IrBuilder::getRule(TokenType type) {
+    static const ParseRule RULES[]{
+            {&IrBuilder::grouping,    &IrBuilder::call,       Precedence::Call}, //left paren
+            {nullptr,                 nullptr,                Precedence::None}, // right paren
+            {&IrBuilder::mapLiteral,  nullptr,                Precedence::None}, // left brace
+            {nullptr,                 nullptr,                Precedence::None}, // right brace
+            {&IrBuilder::listLiteral, &IrBuilder::subscript,  Precedence::Call}, // left bracket
+            {nullptr,                 nullptr,                Precedence::None}, // right bracket
+            {nullptr,                 nullptr,                Precedence::None}, // colon
+            {nullptr,                 nullptr,                Precedence::None}, // comma
+            {nullptr,                 nullptr,                Precedence::None}, // dot
+            {&IrBuilder::unary,       &IrBuilder::binary,     Precedence::Term}, // minus
+            {nullptr,                 &IrBuilder::binary,     Precedence::Term}, // plus
+            {nullptr,                 nullptr,                Precedence::None}, // semicolon
+            {nullptr,                 &IrBuilder::binary,     Precedence::Factor}, // slash
+            {nullptr,                 &IrBuilder::binary,     Precedence::Factor}, // star
+            {nullptr,                 &IrBuilder::binary,     Precedence::Factor}, // percent
+            {&IrBuilder::unary,       nullptr,                Precedence::None}, // bang
+            {nullptr,                 &IrBuilder::binary,     Precedence::Equality}, // bang equal
+            {nullptr,                 nullptr,                Precedence::None}, // equal
+            {nullptr,                 &IrBuilder::binary,     Precedence::Equality}, // equal equal
+            {nullptr,                 &IrBuilder::binary,     Precedence::Comparison}, // greater
+            {nullptr,                 &IrBuilder::binary,     Precedence::Comparison}, // greater equal
+            {nullptr,                 &IrBuilder::binary,     Precedence::Comparison}, // less
+            {nullptr,                 &IrBuilder::binary,     Precedence::Comparison}, // less equal
+            {&IrBuilder::variable,    nullptr,                Precedence::None}, // identifier
+            {&IrBuilder::string,      nullptr,                Precedence::None}, // string
+            {&IrBuilder::number,      nullptr,                Precedence::None}, // number
+            {nullptr,                 &IrBuilder::logicalAnd, Precedence::And}, // and
+            {nullptr,                 nullptr,                Precedence::None}, // break
+            {nullptr,                 nullptr,                Precedence::None}, // class
+            {nullptr,                 nullptr,                Precedence::None}, // continue
+            {nullptr,                 nullptr,                Precedence::None}, // else
+            {&IrBuilder::literal,     nullptr,                Precedence::None}, // false
+            {nullptr,                 nullptr,                Precedence::None}, // for
+            {nullptr,                 nullptr,                Precedence::None}, // fun
+            {nullptr,                 nullptr,                Precedence::None}, // if
+            {&IrBuilder::literal,     nullptr,                Precedence::None}, // nil
+            {nullptr,                 &IrBuilder::logicalOr,  Precedence::Or}, // or
+            {nullptr,                 nullptr,                Precedence::None}, // print
+            {nullptr,                 nullptr,                Precedence::None}, // return
+            {nullptr,                 nullptr,                Precedence::None}, // super
+            {nullptr,                 nullptr,                Precedence::None}, // this
+            {&IrBuilder::literal,     nullptr,                Precedence::None}, // true
+            {nullptr,                 nullptr,                Precedence::None}, // var
+            {nullptr,                 nullptr,                Precedence::None}, // while
+            {nullptr,                 nullptr,                Precedence::None}, // yield
+            {nullptr,                 nullptr,                Precedence::None}, // error
+            {nullptr,                 nullptr,                Precedence::None}, // eof
+    };
+    return RULES + static_cast<int>(type);
+}
+
+IrExpr *IrBuilder::parsePrecedence(Precedence precedence) { // NOLINT(misc-no-recursion)
+    advance();
+    PrefixFn prefixRule = getRule(_parser.previous().type)->prefix;
+    if (prefixRule == nullptr) {
+        error("Expect expression.");
+        return constant(Value());
+    }
+
+    bool canAssign = precedence <= Precedence::Assignment;
+    IrExpr *left = (this->*prefixRule)(canAssign);
+
+    while (precedence <= getRule(_parser.current().type)->precedence) {
+        advance();
+        InfixFn infixRule = getRule(_parser.previous().type)->infix;
+        left = (this->*infixRule)(left, canAssign);
+    }
+
+    if (canAssign && match(TokenType::Equal)) {
+        error("Invalid assignment target.");
+    }
+    return left;
+}
+
+IrExpr *IrBuilder::expression() { // NOLINT(misc-no-recursion)
+    return parsePrecedence(Precedence::Assignment);
+}
+
+IrExpr *IrBuilder::binary(IrExpr *left, bool) { // NOLINT(misc-no-recursion)
+    TokenType operatorType = _parser.previous().type;
+    const ParseRule *rule = getRule(operatorType);
+    IrExpr *right = parsePrecedence(static_cast<Precedence>(static_cast<int>(rule->precedence) + 1));
+
+    IrExpr *binary = expr(IrExprKind::Binary);
+    binary->a = left;
+    binary->b = right;
+    switch (operatorType) {
+        case TokenType::BangEqual:
+            binary->op = OpCode::NotEqual;
+            break;
+        case TokenType::EqualEqual:
+            binary->op = OpCode::Equal;
+            break;
+        case TokenType::Greater:
+            binary->op = OpCode::Greater;
+            break;
+        case TokenType::GreaterEqual:
+            binary->op = OpCode::GreaterEqual;
+            break;
+        case TokenType::Less:
+            binary->op = OpCode::Less;
+            break;
+        case TokenType::LessEqual:
+            binary->op = OpCode::LessEqual;
+            break;
+        case TokenType::Plus:
+            binary->op = OpCode::Add;
+            break;
+        case TokenType::Minus:
+            binary->op = OpCode::Subtract;
+            break;
+        case TokenType::Star:
+            binary->op = OpCode::Multiply;
+            break;
+        case TokenType::Slash:
+            binary->op = OpCode::Divide;
+            break;
+        case TokenType::Percent:
+            binary->op = OpCode::Modulo;
+            break;
+        default:
+            break;
+    }
+    return binary;
+}
+
+IrList<IrExpr *> IrBuilder::expressionList(TokenType closing, const char *limitMessage, bool pairs) { // NOLINT(misc-no-recursion)
+    std::vector<IrExpr *> items;
+    if (!check(closing)) {
+        do {
+            items.push_back(expression());
+            if (pairs) {
+                consume(TokenType::Colon, "Expect ':' after map key.");
+                items.push_back(expression());
+            }
+            if (items.size() > (pairs ? 510 : 255)) {
+                error(limitMessage);
+            }
+        } while (match(TokenType::Comma));
+    }
+    return _arena.list(items);
+}
+
+IrExpr *IrBuilder::call(IrExpr *callee, bool) { // NOLINT(misc-no-recursion)
+    IrList<IrExpr *> arguments = expressionList(TokenType::RightParen, "Can't have more than 255 arguments.", false);
+    consume(TokenType::RightParen, "Expect ')' after arguments.");
+
+    IrExpr *call = expr(IrExprKind::Call);
+    call->a = callee;
+    call->items = arguments;
+    return call;
+}
+
+IrExpr *IrBuilder::subscript(IrExpr *target, bool canAssign) { // NOLINT(misc-no-recursion)
+    IrExpr *index = expression();
+    consume(TokenType::RightBracket, "Expect ']' after index.");
+
+    if (canAssign && match(TokenType::Equal)) {
+        IrExpr *value = expression();
+        IrExpr *set = expr(IrExprKind::SetIndex);
+        set->a = target;
+        set->b = index;
+        set->c = value;
+        return set;
+    }
+
+    IrExpr *get = expr(IrExprKind::GetIndex);
+    get->a = target;
+    get->b = index;
+    return get;
+}
+
+IrExpr *IrBuilder::logicalAnd(IrExpr *left, bool) { // NOLINT(misc-no-recursion)
+    IrExpr *right = parsePrecedence(Precedence::And);
+    IrExpr *logical = expr(IrExprKind::And);
+    logical->a = left;
+    logical->b = right;
+    return logical;
+}
+
+IrExpr *IrBuilder::logicalOr(IrExpr *left, bool) { // NOLINT(misc-no-recursion)
+    IrExpr *right = parsePrecedence(Precedence::Or);
+    IrExpr *logical = expr(IrExprKind::Or);
+    logical->a = left;
+    logical->b = right;
+    return logical;
+}
+
+IrExpr *IrBuilder::grouping(bool) { // NOLINT(misc-no-recursion)
+    IrExpr *inner = expression();
+    consume(TokenType::RightParen, "Expect ')' after expression.");
+    return inner;
+}
+
+IrExpr *IrBuilder::listLiteral(bool) { // NOLINT(misc-no-recursion)
+    IrList<IrExpr *> elements =
+            expressionList(TokenType::RightBracket, "Can't have more than 255 elements in a list literal.", false);
+    consume(TokenType::RightBracket, "Expect ']' after list elements.");
+
+    IrExpr *list = expr(IrExprKind::List);
+    list->items = elements;
+    return list;
+}
+
+// a '{' where an expression is expected can't start a block
+IrExpr *IrBuilder::mapLiteral(bool) { // NOLINT(misc-no-recursion)
+    IrList<IrExpr *> entries =
+            expressionList(TokenType::RightBrace, "Can't have more than 255 entries in a map literal.", true);
+    consume(TokenType::RightBrace, "Expect '}' after map entries.");
+
+    IrExpr *map = expr(IrExprKind::Map);
+    map->items = entries;
+    return map;
+}
+
+IrExpr *IrBuilder::literal(bool) {
+    switch (_parser.previous().type) {
+        case TokenType::False:
+            return constant(Value(false));
+        case TokenType::True:
+            return constant(Value(true));
+        default:
+            return constant(Value());
+    }
+}
+
+IrExpr *IrBuilder::number(bool) {
+    return constant(_parser.number());
+}
+
+IrExpr *IrBuilder::string(bool) {
+    return constant(_parser.string(_vm));
+}
+
+IrExpr *IrBuilder::variable(bool canAssign) { // NOLINT(misc-no-recursion)
+    Token name = _parser.previous();
+    int slot = -1;
+    CompilerContext::ResolveResult result = context().resolveLocal(name, slot);
+    if (result == CompilerContext::ResolveResult::Uninitialized) {
+        error("Can't read local variable in its own initializer.");
+    }
+    bool local = result == CompilerContext::ResolveResult::Local;
+
+    IrExpr *variable;
+    if (canAssign && match(TokenType::Equal)) {
+        IrExpr *value = expression();
+        variable = expr(local ? IrExprKind::SetLocal : IrExprKind::SetGlobal);
+        variable->a = value;
+    } else {
+        variable = expr(local ? IrExprKind::GetLocal : IrExprKind::GetGlobal);
+    }
+
+    if (local) {
+        variable->slot = slot;
+        variable->local = _function->slots[slot];
+    } else {
+        variable->value = Value(ObjString::create(_vm, name.start, name.length));
+    }
+    return variable;
+}
+
+// the operand is a whole expression, just like Compiler::unary parses it
+IrExpr *IrBuilder::unary(bool) { // NOLINT(misc-no-recursion)
+    TokenType operatorType = _parser.previous().type;
+    IrExpr *operand = expression();
+
+    IrExpr *unary = expr(IrExprKind::Unary);
+    unary->op = operatorType == TokenType::Bang ? OpCode::Not : OpCode::Negate;
+    unary->a = operand;
+    return unary;
+}
+
+void IrBuilder::declareVariable() {
+    if (context().inGlobalScope()) return;
+
+    const Token &name = _parser.previous();
+    if (context().hasLocal(name)) {
+        error("Already a variable with this name in this scope.");
+    }
+
+    if (!context().addLocal(name)) {
+        error("Too many local variables in function.");
+    }
+}
+
+IrStmt *IrBuilder::defineVariable(const Token &name, IrExpr *value) {
+    if (context().inGlobalScope()) {
+        IrStmt *define = stmt(IrStmtKind::DefineGlobal);
+        define->name = Value(ObjString::create(_vm, name.start, name.length));
+        define->expr = value;
+        return define;
+    }
+
+    context().markLastLocalInitialized();
+    IrStmt *define = stmt(IrStmtKind::DefineLocal);
+    define->expr = value;
+    define->local = _function->locals++;
+    _function->slots[context().localCount() - 1] = define->local;
+    return define;
+}
+
+IrFunction *IrBuilder::function(FunctionType type) { // NOLINT(misc-no-recursion)
+    FunctionState *enclosing = _function;
+    FunctionState state(_vm, type);
+    _function = &state;
+    const Token &name = _parser.previous();
+    context().function()->name = ObjString::create(_vm, name.start, name.length);
+
+    // loops don't reach into the function body
+    int loopScopeDepth = _loopScopeDepth;
+    _loopScopeDepth = -1;
+
+    context().beginScope();
+    consume(TokenType::LeftParen, "Expect '(' after function name.");
+    if (!check(TokenType::RightParen)) {
+        do {
+            context().function()->arity++;
+            if (context().function()->arity > 255) {
+                error("Can't have more than 255 parameters.");
+            }
+            consume(TokenType::Identifier, "Expect parameter name.");
+            declareVariable();
+            context().markLastLocalInitialized();
+            state.slots[context().localCount() - 1] = -1;
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightParen, "Expect ')' after parameters.");
+    consume(TokenType::LeftBrace, "Expect '{' before function body.");
+
+    auto function = _arena.make<IrFunction>();
+    function->function = context().function();
+    function->body = declarations(TokenType::RightBrace);
+    consume(TokenType::RightBrace, "Expect '}' after block.");
+    function->functions = _arena.list(state.functions);
+    function->locals = state.locals;
+    function->line = _parser.previous().line;
+
+    _function = enclosing;
+    _function->functions.push_back(function);
+    _loopScopeDepth = loopScopeDepth;
+    return function;
+}
+
+IrStmt *IrBuilder::funDeclaration() { // NOLINT(misc-no-recursion)
+    consume(TokenType::Identifier, "Expect function name.");
+    Token name = _parser.previous();
+    declareVariable();
+    // a function may refer to itself
+    if (!context().inGlobalScope()) context().markLastLocalInitialized();
+
+    IrFunction *function = this->function(FunctionType::Function);
+    IrExpr *value = expr(IrExprKind::Function);
+    value->function = function;
+    return defineVariable(name, value);
+}
+
+IrStmt *IrBuilder::varDeclaration() { // NOLINT(misc-no-recursion)
+    consume(TokenType::Identifier, "Expect variable name.");
+    Token name = _parser.previous();
+    declareVariable();
+
+    IrExpr *value = match(TokenType::Equal) ? expression() : constant(Value());
+    consume(TokenType::Semicolon, "Expect ';' after variable declaration.");
+
+    return defineVariable(name, value);
+}
+
+IrStmt *IrBuilder::expressionStatement() { // NOLINT(misc-no-recursion)
+    IrExpr *value = expression();
+    consume(TokenType::Semicolon, "Expect ';' after expression.");
+
+    IrStmt *statement = stmt(IrStmtKind::Expression);
+    statement->expr = value;
+    return statement;
+}
+
+IrStmt *IrBuilder::breakStatement() {
+    if (_loopScopeDepth == -1) {
+        error("Can't use 'break' outside of a loop.");
+    }
+
+    consume(TokenType::Semicolon, "Expect';' after 'break'.");
+
+    // loop statements always introduce a new scope, thus _loopScopeDepth - 1
+    IrStmt *statement = stmt(IrStmtKind::Break);
+    statement->pops = context().numLocalsTill(_loopScopeDepth - 1);
+    return statement;
+}
+
+IrStmt *IrBuilder::continueStatement() {
+    if (_loopScopeDepth == -1) {
+        error("Can't use 'continue' outside of a loop.");
+    }
+
+    consume(TokenType::Semicolon, "Expect';' after 'continue'.");
+
+    IrStmt *statement = stmt(IrStmtKind::Continue);
+    statement->pops = context().numLocalsTill(_loopScopeDepth);
+    return statement;
+}
+
+IrStmt *IrBuilder::forStatement() { // NOLINT(misc-no-recursion)
+    context().beginScope();
+    IrStmt *loop = stmt(IrStmtKind::Loop);
+
+    consume(TokenType::LeftParen, "Expect '(' after 'for'.");
+    if (match(TokenType::Semicolon)) {
+        // no initializer
+    } else if (match(TokenType::Var)) {
+        loop->init = varDeclaration();
+    } else {
+        loop->init = expressionStatement();
+    }
+
+    int loopScopeDepth = _loopScopeDepth;
+    _loopScopeDepth = context().scopeDepth();
+
+    if (!match(TokenType::Semicolon)) {
+        loop->expr = expression();
+        consume(TokenType::Semicolon, "Expect ';' after loop condition.");
+    }
+
+    if (!match(TokenType::RightParen)) {
+        loop->increment = expression();
+        consume(TokenType::RightParen, "Expect ')' after for clauses.");
+    }
+
+    loop->body = statement();
+    _loopScopeDepth = loopScopeDepth;
+
+    loop->pops = context().endScope();
+    loop->line = _parser.previous().line;
+    return loop;
+}
+
+IrStmt *IrBuilder::ifStatement() { // NOLINT(misc-no-recursion)
+    consume(TokenType::LeftParen, "Expect '(' after 'if'.");
+    IrExpr *condition = expression();
+    consume(TokenType::RightParen, "Expect ')' after condition.");
+
+    IrStmt *branch = stmt(IrStmtKind::If);
+    branch->expr = condition;
+    branch->body = statement();
+    if (match(TokenType::Else)) {
+        branch->otherwise = statement();
+    }
+    return branch;
+}
+
+IrStmt *IrBuilder::printStatement() { // NOLINT(misc-no-recursion)
+    IrExpr *value = expression();
+    consume(TokenType::Semicolon, "Expect ';' after value.");
+
+    IrStmt *statement = stmt(IrStmtKind::Print);
+    statement->expr = value;
+    return statement;
+}
+
+IrStmt *IrBuilder::returnStatement() { // NOLINT(misc-no-recursion)
+    if (context().type() == FunctionType::Script) {
+        error("Can't return from top-level code.");
+    }
+
+    IrExpr *value = nullptr;
+    if (!match(TokenType::Semicolon)) {
+        value = expression();
+        consume(TokenType::Semicolon, "Expect ';' after return value.");
+    }
+
+    IrStmt *statement = stmt(IrStmtKind::Return);
+    statement->expr = value;
+    return statement;
+}
+
+IrStmt *IrBuilder::whileStatement() { // NOLINT(misc-no-recursion)
+    context().beginScope();
+    IrStmt *loop = stmt(IrStmtKind::Loop);
+
+    int loopScopeDepth = _loopScopeDepth;
+    _loopScopeDepth = context().scopeDepth();
+
+    consume(TokenType::LeftParen, "Expect '(' after 'while'.");
+    loop->expr = expression();
+    consume(TokenType::RightParen, "Expect ')' after condition.");
+
+    loop->body = statement();
+    _loopScopeDepth = loopScopeDepth;
+
+    loop->pops = context().endScope();
+    loop->line = _parser.previous().line;
+    return loop;
+}
+
+IrStmt *IrBuilder::yieldStatement() { // NOLINT(misc-no-recursion)
+    IrExpr *value = nullptr;
+    if (!match(TokenType::Semicolon)) {
+        value = expression();
+        consume(TokenType::Semicolon, "Expect ';' after yield value.");
+    }
+
+    IrStmt *statement = stmt(IrStmtKind::Yield);
+    statement->expr = value;
+    return statement;
+}
+
+IrStmt *IrBuilder::block() { // NOLINT(misc-no-recursion)
+    context().beginScope();
+    IrStmt *block = stmt(IrStmtKind::Block);
+    block->stmts = declarations(TokenType::RightBrace);
+    consume(TokenType::RightBrace, "Expect '}' after block.");
+    block->pops = context().endScope();
+    block->line = _parser.previous().line;
+    return block;
+}
+
+IrStmt *IrBuilder::statement() { // NOLINT(misc-no-recursion)
+    if (match(TokenType::Print)) return printStatement();
+    if (match(TokenType::Break)) return breakStatement();
+    if (match(TokenType::Continue)) return continueStatement();
+    if (match(TokenType::For)) return forStatement();
+    if (match(TokenType::If)) return ifStatement();
+    if (match(TokenType::Return)) return returnStatement();
+    if (match(TokenType::While)) return whileStatement();
+    if (match(TokenType::Yield)) return yieldStatement();
+    if (match(TokenType::LeftBrace)) return block();
+    return expressionStatement();
+}
+
+IrStmt *IrBuilder::declaration() { // NOLINT(misc-no-recursion)
+    IrStmt *declaration;
+    if (match(TokenType::Fun)) {
+        declaration = funDeclaration();
+    } else if (match(TokenType::Var)) {
+        declaration = varDeclaration();
+    } else {
+        declaration = statement();
+    }
+    _parser.synchronize();
+    return declaration;
+}
+
+IrList<IrStmt *> IrBuilder::declarations(TokenType closing) { // NOLINT(misc-no-recursion)
+    std::vector<IrStmt *> stmts;
+    while (!check(closing) && !check(TokenType::Eof)) {
+        stmts.push_back(declaration());
+    }
+    return _arena.list(stmts);
+}
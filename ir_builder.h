@@ -0,0 +1,147 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_IR_BUILDER_H
+#define CPPLOX_IR_BUILDER_H
+
+#include <array>
+#include <vector>
+
+#include "compiler_context.h"
+#include "ir.h"
+#include "parser.h"
+
+// parses the same grammar as Compiler into ir instead of bytecode, scopes and slots are resolved on the way
+class IrBuilder {
+public:
+    IrBuilder(VM &vm, IrArena &arena) : _vm(vm), _arena(arena) {}
+
+    // null after a syntax error, reported just like Compiler reports it
+    IrFunction *build(const char *source, int line = 1);
+
+private:
+    // the function being parsed, with the local id each of its slots holds right now
+    struct FunctionState {
+        CompilerContext context;
+        std::array<int, UINT8_MAX + 1> slots{};
+        int locals = 0;
+        std::vector<IrFunction *> functions;
+
+        FunctionState(VM &vm, FunctionType type) : context(vm, type) {}
+    };
+
+    inline void advance() { _parser.advance(); }
+
+    inline void consume(TokenType type, const char *message) { _parser.consume(type, message); }
+
+    [[nodiscard]] inline bool check(TokenType type) const { return _parser.check(type); }
+
+    inline bool match(TokenType type) { return _parser.match(type); }
+
+    inline void error(const char *message) { _parser.error(message); }
+
+    inline CompilerContext &context() { return _function->context; }
+
+    IrExpr *expr(IrExprKind kind);
+
+    IrStmt *stmt(IrStmtKind kind);
+
+    IrExpr *constant(Value value);
+
+    enum class Precedence {
+        None, Assignment, Or, And, Equality, Comparison, Term, Factor, Unary, Call, Primary
+    };
+
+    typedef IrExpr *(IrBuilder::*PrefixFn)(bool canAssign);
+
+    typedef IrExpr *(IrBuilder::*InfixFn)(IrExpr *left, bool canAssign);
+
+    struct ParseRule {
+        PrefixFn prefix = nullptr;
+        InfixFn infix = nullptr;
+        Precedence precedence = Precedence::None;
+    };
+
+    static const ParseRule *getRule(TokenType type);
+
+    IrExpr *parsePrecedence(Precedence precedence);
+
+    IrExpr *expression();
+
+    IrExpr *binary(IrExpr *left, bool canAssign);
+
+    IrExpr *call(IrExpr *callee, bool canAssign);
+
+    IrExpr *subscript(IrExpr *target, bool canAssign);
+
+    IrExpr *logicalAnd(IrExpr *left, bool canAssign);
+
+    IrExpr *logicalOr(IrExpr *left, bool canAssign);
+
+    IrExpr *grouping(bool canAssign);
+
+    IrExpr *listLiteral(bool canAssign);
+
+    IrExpr *mapLiteral(bool canAssign);
+
+    IrExpr *literal(bool canAssign);
+
+    IrExpr *number(bool canAssign);
+
+    IrExpr *string(bool canAssign);
+
+    IrExpr *variable(bool canAssign);
+
+    IrExpr *unary(bool canAssign);
+
+    // expressions separated by commas up to closing, counting them against limitMessage
+    IrList<IrExpr *> expressionList(TokenType closing, const char *limitMessage, bool pairs);
+
+    void declareVariable();
+
+    // a DefineGlobal or DefineLocal for the variable just parsed, the local initialized
+    IrStmt *defineVariable(const Token &name, IrExpr *value);
+
+    IrFunction *function(FunctionType type);
+
+    IrStmt *funDeclaration();
+
+    IrStmt *varDeclaration();
+
+    IrStmt *expressionStatement();
+
+    IrStmt *breakStatement();
+
+    IrStmt *continueStatement();
+
+    IrStmt *forStatement();
+
+    IrStmt *ifStatement();
+
+    IrStmt *printStatement();
+
+    IrStmt *returnStatement();
+
+    IrStmt *whileStatement();
+
+    IrStmt *yieldStatement();
+
+    IrStmt *block();
+
+    IrStmt *statement();
+
+    IrStmt *declaration();
+
+    IrList<IrStmt *> declarations(TokenType closing);
+
+    VM &_vm;
+    IrArena &_arena;
+    Parser _parser;
+    FunctionState *_function = nullptr;
+
+    // scope depth of the innermost loop, -1 outside of loops
+    int _loopScopeDepth = -1;
+};
+
+#endif //CPPLOX_IR_BUILDER_H
@@ -0,0 +1,319 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "ir_compiler.h"
+
+#include <cstring>
+
+#include "chunk.h"
+#include "ir_builder.h"
+#include "vm.h"
+
+ObjFunction *IrCompiler::compile(const char *source, int line) {
+    IrArena arena;
+    IrBuilder builder(_vm, arena);
+    IrFunction *script = builder.build(source, line);
+    _irBytes = arena.bytes();
+    if (script == nullptr) return nullptr;
+
+    runPipeline(_vm, arena, _pipeline, script);
+
+    _hadError = false;
+    _loopStart = -1;
+    _loopBreakJumps.clear();
+    ObjFunction *function = lower(script);
+    return _hadError ? nullptr : function;
+}
+
+ObjFunction *IrCompiler::lower(IrFunction *function) { // NOLINT(misc-no-recursion)
+    ObjFunction *enclosing = _function;
+    int loopStart = _loopStart;
+    std::vector<int> loopBreakJumps = std::move(_loopBreakJumps);
+    _function = function->function;
+    _loopStart = -1;
+
+    for (const IrStmt *stmt: function->body) {
+        emit(stmt);
+    }
+    emitByte(OpCode::Nil, function->line);
+    emitByte(OpCode::Return, function->line);
+    if (!_hadError) currentChunk().simplifyJumps();
+
+#ifdef DEBUG_PRINT_CODE
+    if (!_hadError) {
+        ObjString *name = _function->name;
+        currentChunk().disassemble(name != nullptr ? name->chars() : "<script>", _vm.outputStream());
+    }
+#endif
+
+    ObjFunction *lowered = _function;
+    _function = enclosing;
+    _loopStart = loopStart;
+    _loopBreakJumps = std::move(loopBreakJumps);
+    return lowered;
+}
+
+// the parser has reported syntax errors by now, what is left are limits of the bytecode
+void IrCompiler::error(int line, const char *message) {
+    if (_hadError) return;
+    fprintf(_vm.errorStream(), "[line %d] Error: %s\n", line, message);
+    _hadError = true;
+}
+
+void IrCompiler::emitByte(uint8_t byte, int line) {
+    currentChunk().write(byte, line);
+}
+
+void IrCompiler::emitBytes(OpCode opCode, uint8_t byte, int line) {
+    emitByte(opCode, line);
+    emitByte(byte, line);
+}
+
+void IrCompiler::emitPops(int count, int line) {
+    for (int i = 0; i < count; i++) {
+        emitByte(OpCode::Pop, line);
+    }
+}
+
+void IrCompiler::emitLoop(int loopStart, int line) {
+    emitByte(OpCode::Loop, line);
+
+    int offset = currentChunk().count() - loopStart + 2;
+    if (offset > UINT16_MAX) error(line, "Loop body too large.");
+
+    emitByte((offset >> 8) & 0xFF, line);
+    emitByte(offset & 0xFF, line);
+}
+
+int IrCompiler::emitJump(OpCode instruction, int line) {
+    emitByte(instruction, line);
+    emitByte(0xFF, line);
+    emitByte(0xFF, line);
+    return currentChunk().count() - 2;
+}
+
+void IrCompiler::patchJump(int offset, int line) {
+    int jump = currentChunk().count() - offset - 2;
+
+    if (jump > UINT16_MAX) {
+        error(line, "Too much code to jump over.");
+    }
+
+    currentChunk().patch(offset, (jump >> 8) & 0xFF);
+    currentChunk().patch(offset + 1, jump & 0xFF);
+}
+
+// numbers by their bits so 0 and -0 stay apart, strings by their characters, objects by identity
+static bool sameConstant(const Value &a, const Value &b) {
+    if (a.isNumber() && b.isNumber()) {
+        double x = a.asNumber(), y = b.asNumber();
+        return memcmp(&x, &y, sizeof(double)) == 0;
+    }
+    if (a.isShortString() && b.isShortString()) return a.asText() == b.asText();
+    return a.isObj() && b.isObj() && a.asObj() == b.asObj();
+}
+
+uint8_t IrCompiler::makeConstant(Value value, int line) {
+    const Value *constants = currentChunk().constants();
+    for (int i = 0; i < currentChunk().constantCount(); i++) {
+        if (sameConstant(constants[i], value)) return i;
+    }
+
+    int constant = currentChunk().addConstant(value);
+    if (constant > UINT8_MAX) {
+        error(line, "Too many constants in one chunk.");
+        return 0;
+    }
+    return constant;
+}
+
+void IrCompiler::emitConstant(Value value, int line) {
+    if (value.isNil()) {
+        emitByte(OpCode::Nil, line);
+    } else if (value.isBool()) {
+        emitByte(value.asBool() ? OpCode::True : OpCode::False, line);
+    } else {
+        emitBytes(OpCode::Constant, makeConstant(value, line), line);
+    }
+}
+
+void IrCompiler::emit(const IrExpr *expr) { // NOLINT(misc-no-recursion)
+    int line = expr->line;
+    switch (expr->kind) {
+        case IrExprKind::Constant:
+            emitConstant(expr->value, line);
+            break;
+        case IrExprKind::GetLocal:
+            emitBytes(OpCode::GetLocal, expr->slot, line);
+            break;
+        case IrExprKind::SetLocal:
+            emit(expr->a);
+            emitBytes(OpCode::SetLocal, expr->slot, line);
+            break;
+        case IrExprKind::GetGlobal:
+            emitBytes(OpCode::GetGlobal, makeConstant(expr->value, line), line);
+            break;
+        case IrExprKind::SetGlobal:
+            emit(expr->a);
+            emitBytes(OpCode::SetGlobal, makeConstant(expr->value, line), line);
+            break;
+        case IrExprKind::Unary:
+            emit(expr->a);
+            emitByte(expr->op, line);
+            break;
+        case IrExprKind::Binary:
+            emit(expr->a);
+            emit(expr->b);
+            emitByte(expr->op, line);
+            break;
+        case IrExprKind::And:
+        case IrExprKind::Or: {
+            emit(expr->a);
+            int endJump = emitJump(expr->kind == IrExprKind::And ? OpCode::JumpIfFalse : OpCode::JumpIfTrue, line);
+            emitByte(OpCode::Pop, line);
+            emit(expr->b);
+            patchJump(endJump, line);
+            break;
+        }
+        case IrExprKind::Call:
+            emit(expr->a);
+            for (const IrExpr *argument: expr->items) {
+                emit(argument);
+            }
+            emitBytes(OpCode::Call, expr->items.count, line);
+            break;
+        case IrExprKind::List:
+            for (const IrExpr *element: expr->items) {
+                emit(element);
+            }
+            emitBytes(OpCode::BuildList, expr->items.count, line);
+            break;
+        case IrExprKind::Map:
+            for (const IrExpr *item: expr->items) {
+                emit(item);
+            }
+            emitBytes(OpCode::BuildMap, expr->items.count / 2, line);
+            break;
+        case IrExprKind::GetIndex:
+            emit(expr->a);
+            emit(expr->b);
+            emitByte(OpCode::GetIndex, line);
+            break;
+        case IrExprKind::SetIndex:
+            emit(expr->a);
+            emit(expr->b);
+            emit(expr->c);
+            emitByte(OpCode::SetIndex, line);
+            break;
+        case IrExprKind::Function:
+            emitConstant(Value(lower(expr->function)), line);
+            break;
+    }
+}
+
+void IrCompiler::emit(const IrStmt *stmt) { // NOLINT(misc-no-recursion)
+    int line = stmt->line;
+    switch (stmt->kind) {
+        case IrStmtKind::Expression:
+            emit(stmt->expr);
+            emitByte(OpCode::Pop, line);
+            break;
+        case IrStmtKind::Print:
+            emit(stmt->expr);
+            emitByte(OpCode::Print, line);
+            break;
+        case IrStmtKind::DefineGlobal:
+            emit(stmt->expr);
+            emitBytes(OpCode::DefineGlobal, makeConstant(stmt->name, line), line);
+            break;
+        case IrStmtKind::DefineLocal:
+            // the value stays on the stack as the local's slot
+            emit(stmt->expr);
+            break;
+        case IrStmtKind::Block:
+            for (const IrStmt *child: stmt->stmts) {
+                emit(child);
+            }
+            emitPops(stmt->pops, line);
+            break;
+        case IrStmtKind::If: {
+            emit(stmt->expr);
+            int thenJump = emitJump(OpCode::JumpIfFalse, line);
+            emitByte(OpCode::Pop, line);
+            emit(stmt->body);
+            int elseJump = emitJump(OpCode::Jump, line);
+            patchJump(thenJump, line);
+            emitByte(OpCode::Pop, line);
+            if (stmt->otherwise != nullptr) emit(stmt->otherwise);
+            patchJump(elseJump, line);
+            break;
+        }
+        case IrStmtKind::Loop: {
+            if (stmt->init != nullptr) emit(stmt->init);
+
+            int loopStart = _loopStart;
+            std::vector<int> loopBreakJumps = std::move(_loopBreakJumps);
+            _loopStart = currentChunk().count();
+
+            int exitJump = -1;
+            if (stmt->expr != nullptr) {
+                emit(stmt->expr);
+                exitJump = emitJump(OpCode::JumpIfFalse, line);
+                emitByte(OpCode::Pop, line);
+            }
+
+            if (stmt->increment != nullptr) {
+                int bodyJump = emitJump(OpCode::Jump, line);
+                int incrementStart = currentChunk().count();
+                emit(stmt->increment);
+                emitByte(OpCode::Pop, line);
+
+                emitLoop(_loopStart, line);
+                _loopStart = incrementStart;
+                patchJump(bodyJump, line);
+            }
+
+            emit(stmt->body);
+            emitLoop(_loopStart, line);
+
+            if (exitJump != -1) {
+                patchJump(exitJump, line);
+                emitByte(OpCode::Pop, line);
+            }
+
+            _loopStart = loopStart;
+            std::swap(_loopBreakJumps, loopBreakJumps);
+
+            emitPops(stmt->pops, line);
+            for (int breakJump: loopBreakJumps) {
+                patchJump(breakJump, line);
+            }
+            break;
+        }
+        case IrStmtKind::Break:
+            emitPops(stmt->pops, line);
+            _loopBreakJumps.push_back(emitJump(OpCode::Jump, line));
+            break;
+        case IrStmtKind::Continue:
+            emitPops(stmt->pops, line);
+            emitLoop(_loopStart, line);
+            break;
+        case IrStmtKind::Return:
+            if (stmt->expr != nullptr) {
+                emit(stmt->expr);
+            } else {
+                emitByte(OpCode::Nil, line);
+            }
+            emitByte(OpCode::Return, line);
+            break;
+        case IrStmtKind::Yield:
+            if (stmt->expr != nullptr) {
+                emit(stmt->expr);
+            } else {
+                emitByte(OpCode::Nil, line);
+            }
+            emitByte(OpCode::Yield, line);
+            break;
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_IR_COMPILER_H
+#define CPPLOX_IR_COMPILER_H
+
+#include <utility>
+#include <vector>
+
+#include "ir.h"
+#include "ir_passes.h"
+#include "object.h"
+
+// compiles through the ir, running pipeline over it before lowering to the same bytecode Compiler emits
+class IrCompiler {
+public:
+    explicit IrCompiler(VM &vm, IrPipeline pipeline = defaultPipeline()) : _vm(vm), _pipeline(std::move(pipeline)) {}
+
+    // nullptr after reporting compile errors
+    ObjFunction *compile(const char *source, int line = 1);
+
+    // bytes the ir of the last compile took
+    [[nodiscard]] inline size_t irBytes() const { return _irBytes; }
+
+private:
+    ObjFunction *lower(IrFunction *function);
+
+    inline Chunk &currentChunk() { return _function->chunk; }
+
+    void error(int line, const char *message);
+
+    void emitByte(uint8_t byte, int line);
+
+    inline void emitByte(OpCode opCode, int line) { emitByte(static_cast<uint8_t>(opCode), line); }
+
+    void emitBytes(OpCode opCode, uint8_t byte, int line);
+
+    void emitPops(int count, int line);
+
+    void emitLoop(int loopStart, int line);
+
+    int emitJump(OpCode instruction, int line);
+
+    void patchJump(int offset, int line);
+
+    // constants are shared within a chunk, unlike Compiler which adds one per use
+    uint8_t makeConstant(Value value, int line);
+
+    void emitConstant(Value value, int line);
+
+    void emit(const IrExpr *expr);
+
+    void emit(const IrStmt *stmt);
+
+    VM &_vm;
+    IrPipeline _pipeline;
+    ObjFunction *_function = nullptr;
+    bool _hadError = false;
+    size_t _irBytes = 0;
+
+    // where continue jumps and the breaks still waiting for the end of the innermost loop
+    int _loopStart = -1;
+    std::vector<int> _loopBreakJumps;
+};
+
+#endif //CPPLOX_IR_COMPILER_H
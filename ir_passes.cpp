@@ -0,0 +1,321 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "ir_passes.h"
+
+#include <string>
+
+#include "vm.h"
+
+const IrPipeline &defaultPipeline() {
+    static const IrPipeline PIPELINE{
+            IrPass::FoldConstants,
+            IrPass::PropagateConstants,
+            IrPass::FoldConstants,
+            IrPass::PruneBranches,
+            IrPass::RemoveUnreachable,
+    };
+    return PIPELINE;
+}
+
+// children before their parent, nested functions are left to the caller
+template<typename Visit>
+static void walk(IrExpr *expr, const Visit &visit) { // NOLINT(misc-no-recursion)
+    if (expr == nullptr) return;
+    walk(expr->a, visit);
+    walk(expr->b, visit);
+    walk(expr->c, visit);
+    for (IrExpr *item: expr->items) {
+        walk(item, visit);
+    }
+    visit(expr);
+}
+
+template<typename VisitStmt, typename VisitExpr>
+static void walk(IrStmt *stmt, const VisitStmt &visitStmt, const VisitExpr &visitExpr) { // NOLINT(misc-no-recursion)
+    if (stmt == nullptr) return;
+    visitStmt(stmt);
+    walk(stmt->init, visitStmt, visitExpr);
+    walk(stmt->expr, visitExpr);
+    walk(stmt->increment, visitExpr);
+    walk(stmt->body, visitStmt, visitExpr);
+    walk(stmt->otherwise, visitStmt, visitExpr);
+    for (IrStmt *child: stmt->stmts) {
+        walk(child, visitStmt, visitExpr);
+    }
+}
+
+template<typename VisitStmt, typename VisitExpr>
+static void walk(const IrList<IrStmt *> &stmts, const VisitStmt &visitStmt, const VisitExpr &visitExpr) {
+    for (IrStmt *stmt: stmts) {
+        walk(stmt, visitStmt, visitExpr);
+    }
+}
+
+static void makeConstant(IrExpr *expr, Value value) {
+    expr->kind = IrExprKind::Constant;
+    expr->value = value;
+    expr->a = expr->b = expr->c = nullptr;
+    expr->items = {};
+}
+
+// an empty block emits nothing, it stands in for statements a pass dropped
+static void makeEmpty(IrStmt *stmt) {
+    *stmt = IrStmt();
+    stmt->kind = IrStmtKind::Block;
+}
+
+static bool isEmpty(const IrStmt *stmt) {
+    return stmt->kind == IrStmtKind::Block && stmt->stmts.count == 0 && stmt->pops == 0;
+}
+
+static bool isConstant(const IrExpr *expr) {
+    return expr != nullptr && expr->kind == IrExprKind::Constant;
+}
+
+// only what the vm would compute without a runtime error, everything else is left for it to report
+static bool foldBinary(VM &vm, OpCode op, const Value &a, const Value &b, Value &result) {
+    switch (op) {
+        case OpCode::Equal:
+            result = Value(a == b);
+            return true;
+        case OpCode::NotEqual:
+            result = Value(a != b);
+            return true;
+        case OpCode::Add:
+            if (a.isText() && b.isText()) {
+                std::string text(a.asText());
+                text += b.asText();
+                result = Value(vm, text.data(), static_cast<int>(text.size()));
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    if (!a.isNumber() || !b.isNumber()) return false;
+
+    switch (op) {
+        case OpCode::Add:
+            result = a + b;
+            break;
+        case OpCode::Subtract:
+            result = a - b;
+            break;
+        case OpCode::Multiply:
+            result = a * b;
+            break;
+        case OpCode::Divide:
+            result = a / b;
+            break;
+        case OpCode::Modulo:
+            result = a % b;
+            break;
+        case OpCode::Greater:
+            result = a > b;
+            break;
+        case OpCode::GreaterEqual:
+            result = a >= b;
+            break;
+        case OpCode::Less:
+            result = a < b;
+            break;
+        case OpCode::LessEqual:
+            result = a <= b;
+            break;
+        default:
+            return false;
+    }
+    return !result.isNil();
+}
+
+static void fold(VM &vm, IrExpr *expr) {
+    switch (expr->kind) {
+        case IrExprKind::Unary: {
+            if (!isConstant(expr->a)) break;
+            const Value &operand = expr->a->value;
+            if (expr->op == OpCode::Not) {
+                makeConstant(expr, Value(operand.isFalsey()));
+            } else if (operand.isNumber()) {
+                makeConstant(expr, -operand);
+            }
+            break;
+        }
+        case IrExprKind::Binary: {
+            Value result;
+            if (isConstant(expr->a) && isConstant(expr->b) &&
+                foldBinary(vm, expr->op, expr->a->value, expr->b->value, result)) {
+                makeConstant(expr, result);
+            }
+            break;
+        }
+        case IrExprKind::And:
+            // the right side only runs when the constant doesn't already decide
+            if (isConstant(expr->a)) *expr = expr->a->value.isFalsey() ? *expr->a : *expr->b;
+            break;
+        case IrExprKind::Or:
+            if (isConstant(expr->a)) *expr = expr->a->value.isFalsey() ? *expr->b : *expr->a;
+            break;
+        default:
+            break;
+    }
+}
+
+static void foldConstants(VM &vm, IrFunction *function) {
+    walk(function->body, [](IrStmt *) {}, [&vm](IrExpr *expr) { fold(vm, expr); });
+}
+
+static void propagateConstants(IrFunction *function) {
+    std::vector<IrExpr *> initializers(function->locals, nullptr);
+    std::vector<bool> assigned(function->locals, false);
+    walk(function->body, [&initializers](IrStmt *stmt) {
+        if (stmt->kind == IrStmtKind::DefineLocal && isConstant(stmt->expr)) initializers[stmt->local] = stmt->expr;
+    }, [&assigned](IrExpr *expr) {
+        if (expr->kind == IrExprKind::SetLocal && expr->local != -1) assigned[expr->local] = true;
+    });
+
+    walk(function->body, [](IrStmt *) {}, [&initializers, &assigned](IrExpr *expr) {
+        if (expr->kind != IrExprKind::GetLocal || expr->local == -1) return;
+        if (initializers[expr->local] != nullptr && !assigned[expr->local]) {
+            makeConstant(expr, initializers[expr->local]->value);
+        }
+    });
+}
+
+static void pruneBranches(IrArena &arena, IrStmt *stmt);
+
+static void pruneBranches(IrArena &arena, IrList<IrStmt *> &stmts) { // NOLINT(misc-no-recursion)
+    int count = 0;
+    for (IrStmt *stmt: stmts) {
+        pruneBranches(arena, stmt);
+        if (!isEmpty(stmt)) stmts.items[count++] = stmt;
+    }
+    stmts.count = count;
+}
+
+static void pruneBranches(IrArena &arena, IrStmt *stmt) { // NOLINT(misc-no-recursion)
+    switch (stmt->kind) {
+        case IrStmtKind::Expression:
+            if (isConstant(stmt->expr)) makeEmpty(stmt);
+            break;
+        case IrStmtKind::Block:
+            pruneBranches(arena, stmt->stmts);
+            break;
+        case IrStmtKind::If: {
+            pruneBranches(arena, stmt->body);
+            if (stmt->otherwise != nullptr) pruneBranches(arena, stmt->otherwise);
+            if (!isConstant(stmt->expr)) break;
+
+            // a branch is a statement, never a declaration, so nothing it declares outlives it
+            IrStmt *taken = stmt->expr->value.isFalsey() ? stmt->otherwise : stmt->body;
+            if (taken != nullptr) {
+                *stmt = *taken;
+            } else {
+                makeEmpty(stmt);
+            }
+            break;
+        }
+        case IrStmtKind::Loop: {
+            if (stmt->init != nullptr) pruneBranches(arena, stmt->init);
+            pruneBranches(arena, stmt->body);
+            if (!isConstant(stmt->expr)) break;
+
+            if (!stmt->expr->value.isFalsey()) {
+                // an endless loop needs no check, just like a for without a condition
+                stmt->expr = nullptr;
+                break;
+            }
+
+            // only the initializer ever runs, its local still goes out of scope at the end
+            IrStmt *init = stmt->init;
+            int pops = stmt->pops;
+            int line = stmt->line;
+            makeEmpty(stmt);
+            if (init != nullptr && !isEmpty(init)) stmt->stmts = arena.list(std::vector<IrStmt *>{init});
+            stmt->pops = pops;
+            stmt->line = line;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static bool terminates(const IrStmt *stmt) { // NOLINT(misc-no-recursion)
+    switch (stmt->kind) {
+        case IrStmtKind::Return:
+        case IrStmtKind::Break:
+        case IrStmtKind::Continue:
+            return true;
+        case IrStmtKind::Block:
+            return stmt->stmts.count > 0 && terminates(stmt->stmts.items[stmt->stmts.count - 1]);
+        case IrStmtKind::If:
+            return stmt->otherwise != nullptr && terminates(stmt->body) && terminates(stmt->otherwise);
+        default:
+            return false;
+    }
+}
+
+static void removeUnreachable(IrStmt *stmt);
+
+// pops is the scope's count of locals to drop at its end, the locals whose declaration is dropped are never pushed
+static void removeUnreachable(IrList<IrStmt *> &stmts, int &pops) { // NOLINT(misc-no-recursion)
+    for (int i = 0; i < stmts.count; i++) {
+        removeUnreachable(stmts.items[i]);
+        if (!terminates(stmts.items[i])) continue;
+
+        for (int j = i + 1; j < stmts.count; j++) {
+            if (stmts.items[j]->kind == IrStmtKind::DefineLocal) pops--;
+        }
+        stmts.count = i + 1;
+        break;
+    }
+}
+
+static void removeUnreachable(IrStmt *stmt) { // NOLINT(misc-no-recursion)
+    switch (stmt->kind) {
+        case IrStmtKind::Block:
+            removeUnreachable(stmt->stmts, stmt->pops);
+            break;
+        case IrStmtKind::If:
+            removeUnreachable(stmt->body);
+            if (stmt->otherwise != nullptr) removeUnreachable(stmt->otherwise);
+            break;
+        case IrStmtKind::Loop:
+            removeUnreachable(stmt->body);
+            break;
+        default:
+            break;
+    }
+}
+
+void runPass(VM &vm, IrArena &arena, IrPass pass, IrFunction *function) { // NOLINT(misc-no-recursion)
+    for (IrFunction *nested: function->functions) {
+        runPass(vm, arena, pass, nested);
+    }
+
+    switch (pass) {
+        case IrPass::FoldConstants:
+            foldConstants(vm, function);
+            break;
+        case IrPass::PropagateConstants:
+            propagateConstants(function);
+            break;
+        case IrPass::PruneBranches:
+            pruneBranches(arena, function->body);
+            break;
+        case IrPass::RemoveUnreachable: {
+            // the frame goes away with the function, its top level pops nothing
+            int pops = 0;
+            removeUnreachable(function->body, pops);
+            break;
+        }
+    }
+}
+
+void runPipeline(VM &vm, IrArena &arena, const IrPipeline &pipeline, IrFunction *function) {
+    for (IrPass pass: pipeline) {
+        runPass(vm, arena, pass, function);
+    }
+}
@@ -0,0 +1,34 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_IR_PASSES_H
+#define CPPLOX_IR_PASSES_H
+
+#include <vector>
+
+#include "forward.h"
+#include "ir.h"
+
+// every pass rewrites a function in place, nested functions included, and keeps the program's output unchanged
+enum class IrPass {
+    // evaluates operators on constants, and/or with a constant left side
+    FoldConstants,
+    // replaces reads of locals that are initialized with a constant and never assigned
+    PropagateConstants,
+    // drops branches and loops a constant condition never takes, and constant expression statements
+    PruneBranches,
+    // drops statements after a return, break or continue
+    RemoveUnreachable,
+};
+
+typedef std::vector<IrPass> IrPipeline;
+
+// fold, propagate, fold what propagating exposed, then clean up the control flow
+const IrPipeline &defaultPipeline();
+
+void runPass(VM &vm, IrArena &arena, IrPass pass, IrFunction *function);
+
+void runPipeline(VM &vm, IrArena &arena, const IrPipeline &pipeline, IrFunction *function);
+
+#endif //CPPLOX_IR_PASSES_H
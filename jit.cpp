@@ -0,0 +1,697 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "jit.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CPPLOX_JIT_SUPPORTED
+
+#include <sys/mman.h>
+
+#endif
+
+#include "chunk.h"
+#include "object.h"
+#include "op_code.h"
+#include "vm.h"
+
+// stack depth is static at every instruction, so stack slots are addressed relative to the frame
+// register usage: rbx = VM *, r12 = frame slots, r13 = chunk constants, r14 = loop budget
+class JitAssembler {
+public:
+    JitAssembler(const Chunk &chunk, int arity, JitCode &jit) : _chunk(chunk), _arity(arity), _jit(jit) {}
+
+    bool assemble();
+
+    [[nodiscard]] inline const std::vector<uint8_t> &buffer() const { return _buf; }
+
+private:
+    enum Reg {
+        Rax = 0, Rcx = 1, Rdx = 2, Rbx = 3, Rsi = 6, Rdi = 7, R12 = 12, R13 = 13, R14 = 14
+    };
+
+    enum Cond {
+        AboveEqual = 0x3, Equal = 0x4, NotEqual = 0x5, Above = 0x7, LessEqual = 0xE
+    };
+
+    static constexpr int32_t TYPE = offsetof(Value, _type);
+    static constexpr int32_t PAYLOAD = offsetof(Value, _as);
+
+    static inline int32_t slot(int index) { return index * static_cast<int32_t>(sizeof(Value)); }
+
+    static inline int32_t typeTag(ValueType type) { return static_cast<int32_t>(type); }
+
+    static int stackEffect(OpCode opCode);
+
+    bool computeStackDepths();
+
+    bool emitInstruction(int offset, int depth);
+
+    inline void emit8(uint8_t byte) { _buf.push_back(byte); }
+
+    void emit32(uint32_t value);
+
+    void emit64(uint64_t value);
+
+    void patch32(int position, int target);
+
+    void emitRex(bool wide, int reg, int base);
+
+    void emitMem(int reg, int base, int32_t disp);
+
+    void emitSse(uint8_t prefix, uint8_t op, int xmm, int base, int32_t disp);
+
+    void emitStoreImm32(int base, int32_t disp, int32_t imm);
+
+    void emitStoreImm64(int base, int32_t disp, int32_t imm);
+
+    void emitCmpImm8(int base, int32_t disp, int8_t imm);
+
+    void emitCmpByteImm8(int base, int32_t disp, int8_t imm);
+
+    void emitLea(int reg, int base, int32_t disp);
+
+    void emitMovImm64(int reg, uint64_t imm);
+
+    int emitJcc(Cond cond);
+
+    int emitJmp();
+
+    void emitCall(const void *function);
+
+    void emitCopy(int fromBase, int32_t fromDisp, int32_t toDisp);
+
+    void emitStoreBool(int index, Cond cond);
+
+    void emitJumpTo(int target, int position);
+
+    void emitDeopt(int offset, int position);
+
+    void emitGuardNumber(int index, int offset);
+
+    const Chunk &_chunk;
+    int _arity;
+    JitCode &_jit;
+    std::vector<uint8_t> _buf;
+    std::vector<std::pair<int, int>> _jumpFixups;
+    std::vector<std::pair<int, int>> _deoptFixups;
+    int _exit = 0;
+};
+
+int JitAssembler::stackEffect(OpCode opCode) {
+    switch (Chunk::genericForm(opCode)) {
+        case OpCode::Constant:
+        case OpCode::Nil:
+        case OpCode::True:
+        case OpCode::False:
+        case OpCode::GetLocal:
+        case OpCode::GetGlobal:
+            return 1;
+        case OpCode::Pop:
+        case OpCode::PopJumpIfFalse:
+        case OpCode::DefineGlobal:
+        case OpCode::Equal:
+        case OpCode::NotEqual:
+        case OpCode::Greater:
+        case OpCode::GreaterEqual:
+        case OpCode::Less:
+        case OpCode::LessEqual:
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide:
+        case OpCode::Modulo:
+        case OpCode::Print:
+        case OpCode::Yield:
+        case OpCode::GetIndex:
+            return -1;
+        case OpCode::SetIndex:
+            return -2;
+        default:
+            return 0;
+    }
+}
+
+bool JitAssembler::computeStackDepths() {
+    const uint8_t *code = _chunk.code();
+    int count = _chunk.count();
+    std::vector<int> &depths = _jit._stackDepths;
+    depths.assign(count, -1);
+
+    // slot 0 holds the function itself, its arguments follow
+    std::vector<std::pair<int, int>> worklist{{0, 1 + _arity}};
+    auto reach = [&](int offset, int depth) {
+        if (offset < 0 || offset >= count) return false;
+        if (depths[offset] == -1) {
+            worklist.emplace_back(offset, depth);
+            return true;
+        }
+        return depths[offset] == depth;
+    };
+
+    while (!worklist.empty()) {
+        auto [offset, depth] = worklist.back();
+        worklist.pop_back();
+        if (depths[offset] != -1) {
+            if (depths[offset] != depth) return false;
+            continue;
+        }
+        depths[offset] = depth;
+        if (depth > _jit._maxStackDepth) _jit._maxStackDepth = depth;
+
+        auto opCode = static_cast<OpCode>(code[offset]);
+        int next = offset + Chunk::instructionSize(opCode);
+        // a call leaves its result in the callee's slot, a list replaces its elements
+        int after = depth + stackEffect(opCode);
+        if (opCode == OpCode::Call) after = depth - code[offset + 1];
+        if (opCode == OpCode::BuildList) after = depth - code[offset + 1] + 1;
+        if (opCode == OpCode::BuildMap) after = depth - 2 * code[offset + 1] + 1;
+        if (after < 1) return false;
+
+        switch (opCode) {
+            case OpCode::Jump:
+            case OpCode::Loop: {
+                int jump = (code[offset + 1] << 8) | code[offset + 2];
+                if (!reach(opCode == OpCode::Jump ? next + jump : next - jump, after)) return false;
+                break;
+            }
+            case OpCode::JumpIfTrue:
+            case OpCode::JumpIfFalse:
+            case OpCode::PopJumpIfFalse: {
+                int jump = (code[offset + 1] << 8) | code[offset + 2];
+                if (!reach(next + jump, after) || !reach(next, after)) return false;
+                break;
+            }
+            case OpCode::Return:
+                break;
+            default:
+                if (!reach(next, after)) return false;
+                break;
+        }
+    }
+
+    // the next push may land one slot above the deepest recorded depth
+    _jit._maxStackDepth++;
+    return true;
+}
+
+bool JitAssembler::assemble() {
+    if (!computeStackDepths()) return false;
+
+    // prologue: save callee-saved registers, load state, jump to the entry instruction
+    emit8(0x53); // push rbx
+    emit8(0x41), emit8(0x54); // push r12
+    emit8(0x41), emit8(0x55); // push r13
+    emit8(0x41), emit8(0x56); // push r14
+    emit8(0x48), emit8(0x83), emit8(0xEC), emit8(0x08); // sub rsp, 8 to keep calls 16 byte aligned
+    emit8(0x48), emit8(0x89), emit8(0xFB); // mov rbx, rdi
+    emit8(0x49), emit8(0x89), emit8(0xF4); // mov r12, rsi
+    emit8(0x49), emit8(0x89), emit8(0xD5); // mov r13, rdx
+    emit8(0x4D), emit8(0x89), emit8(0xC6); // mov r14, r8
+    emit8(0xFF), emit8(0xE1); // jmp rcx
+
+    // epilogue: eax holds the offset to resume interpreting from
+    _exit = static_cast<int>(_buf.size());
+    emit8(0x48), emit8(0x83), emit8(0xC4), emit8(0x08); // add rsp, 8
+    emit8(0x41), emit8(0x5E); // pop r14
+    emit8(0x41), emit8(0x5D); // pop r13
+    emit8(0x41), emit8(0x5C); // pop r12
+    emit8(0x5B); // pop rbx
+    emit8(0xC3); // ret
+
+    int count = _chunk.count();
+    std::vector<int> &entries = _jit._entries;
+    entries.assign(count, -1);
+
+    int offset = 0;
+    while (offset < count) {
+        auto opCode = static_cast<OpCode>(_chunk.code()[offset]);
+        int depth = _jit._stackDepths[offset];
+        if (depth != -1) {
+            entries[offset] = static_cast<int>(_buf.size());
+            if (!emitInstruction(offset, depth)) return false;
+        }
+        offset += Chunk::instructionSize(opCode);
+    }
+
+    for (auto [position, target]: _jumpFixups) {
+        if (entries[target] < 0) return false;
+        patch32(position, entries[target]);
+    }
+
+    // deopt stubs live out of line, one per instruction that has a guard
+    std::vector<int> stubs(count, -1);
+    for (auto [position, target]: _deoptFixups) {
+        if (stubs[target] < 0) {
+            stubs[target] = static_cast<int>(_buf.size());
+            emit8(0xB8); // mov eax, imm32
+            emit32(target);
+            patch32(emitJmp(), _exit);
+        }
+        patch32(position, stubs[target]);
+    }
+
+    return true;
+}
+
+bool JitAssembler::emitInstruction(int offset, int depth) {
+    const uint8_t *code = _chunk.code();
+    // quickened instructions share the generic template, its guards already cover them
+    OpCode opCode = Chunk::genericForm(static_cast<OpCode>(code[offset]));
+    int next = offset + Chunk::instructionSize(opCode);
+    int top = depth - 1;
+
+    switch (opCode) {
+        case OpCode::Constant:
+            emitCopy(R13, slot(code[offset + 1]), slot(depth));
+            break;
+        case OpCode::Nil:
+            emitStoreImm32(R12, slot(depth) + TYPE, typeTag(ValueType::Nil));
+            emitStoreImm64(R12, slot(depth) + PAYLOAD, 0);
+            break;
+        case OpCode::True:
+        case OpCode::False:
+            emitStoreImm32(R12, slot(depth) + TYPE, typeTag(ValueType::Bool));
+            emitStoreImm64(R12, slot(depth) + PAYLOAD, opCode == OpCode::True ? 1 : 0);
+            break;
+        case OpCode::Pop:
+            break;
+        case OpCode::GetLocal:
+            emitCopy(R12, slot(code[offset + 1]), slot(depth));
+            break;
+        case OpCode::SetLocal:
+            emitCopy(R12, slot(top), slot(code[offset + 1]));
+            break;
+        case OpCode::GetGlobal:
+        case OpCode::DefineGlobal:
+        case OpCode::SetGlobal: {
+            emit8(0x48), emit8(0x89), emit8(0xDF); // mov rdi, rbx
+            emitLea(Rsi, R12, slot(opCode == OpCode::GetGlobal ? depth : top));
+            emitLea(Rdx, R13, slot(code[offset + 1]));
+            if (opCode == OpCode::DefineGlobal) {
+                emitCall(reinterpret_cast<const void *>(&JitCode::defineGlobal));
+            } else {
+                emitCall(reinterpret_cast<const void *>(
+                                 opCode == OpCode::GetGlobal ? &JitCode::getGlobal : &JitCode::setGlobal));
+                emit8(0x84), emit8(0xC0); // test al, al
+                emitDeopt(offset, emitJcc(Equal));
+            }
+            break;
+        }
+        case OpCode::Equal:
+        case OpCode::NotEqual:
+            emitLea(Rdi, R12, slot(top - 1));
+            emitCall(reinterpret_cast<const void *>(
+                             opCode == OpCode::Equal ? &JitCode::equal : &JitCode::notEqual));
+            break;
+        case OpCode::Greater:
+        case OpCode::GreaterEqual:
+        case OpCode::Less:
+        case OpCode::LessEqual: {
+            emitGuardNumber(top - 1, offset);
+            emitGuardNumber(top, offset);
+            // a < b is evaluated as b > a so that unordered operands yield false
+            bool swap = opCode == OpCode::Less || opCode == OpCode::LessEqual;
+            emitSse(0xF2, 0x10, 0, R12, slot(swap ? top : top - 1) + PAYLOAD); // movsd xmm0, lhs
+            emitSse(0x66, 0x2E, 0, R12, slot(swap ? top - 1 : top) + PAYLOAD); // ucomisd xmm0, rhs
+            bool strict = opCode == OpCode::Greater || opCode == OpCode::Less;
+            emitStoreBool(top - 1, strict ? Above : AboveEqual);
+            break;
+        }
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide: {
+            static constexpr uint8_t OPS[]{0x58, 0x5C, 0x59, 0x5E};
+            emitGuardNumber(top - 1, offset);
+            emitGuardNumber(top, offset);
+            emitSse(0xF2, 0x10, 0, R12, slot(top - 1) + PAYLOAD); // movsd xmm0, lhs
+            emitSse(0xF2, OPS[static_cast<int>(opCode) - static_cast<int>(OpCode::Add)], 0, R12, slot(top) + PAYLOAD);
+            emitSse(0xF2, 0x11, 0, R12, slot(top - 1) + PAYLOAD); // movsd lhs, xmm0
+            break;
+        }
+        case OpCode::Modulo:
+            emitGuardNumber(top - 1, offset);
+            emitGuardNumber(top, offset);
+            emitSse(0xF2, 0x10, 0, R12, slot(top - 1) + PAYLOAD); // movsd xmm0, lhs
+            emitSse(0xF2, 0x10, 1, R12, slot(top) + PAYLOAD); // movsd xmm1, rhs
+            emitCall(reinterpret_cast<const void *>(static_cast<double (*)(double, double)>(&fmod)));
+            emitSse(0xF2, 0x11, 0, R12, slot(top - 1) + PAYLOAD); // movsd lhs, xmm0
+            break;
+        case OpCode::Not:
+            emitLea(Rdi, R12, slot(top));
+            emitCall(reinterpret_cast<const void *>(&JitCode::logicalNot));
+            break;
+        case OpCode::Negate:
+            emitGuardNumber(top, offset);
+            // btc qword [r12 + disp], 63
+            emitRex(true, 7, R12);
+            emit8(0x0F), emit8(0xBA);
+            emitMem(7, R12, slot(top) + PAYLOAD);
+            emit8(63);
+            break;
+        case OpCode::Print:
+            emit8(0x48), emit8(0x89), emit8(0xDF); // mov rdi, rbx
+            emitLea(Rsi, R12, slot(top));
+            emitCall(reinterpret_cast<const void *>(&JitCode::print));
+            break;
+        case OpCode::BuildList: {
+            int count = code[offset + 1];
+            emit8(0x48), emit8(0x89), emit8(0xDF); // mov rdi, rbx
+            emitLea(Rsi, R12, slot(depth - count));
+            emit8(0xBA); // mov edx, imm32
+            emit32(count);
+            emitCall(reinterpret_cast<const void *>(&JitCode::buildList));
+            break;
+        }
+        case OpCode::BuildMap: {
+            int count = code[offset + 1];
+            emit8(0x48), emit8(0x89), emit8(0xDF); // mov rdi, rbx
+            emitLea(Rsi, R12, slot(depth - 2 * count));
+            emit8(0xBA); // mov edx, imm32
+            emit32(count);
+            emitCall(reinterpret_cast<const void *>(&JitCode::buildMap));
+            emit8(0x84), emit8(0xC0); // test al, al
+            emitDeopt(offset, emitJcc(Equal));
+            break;
+        }
+        case OpCode::GetIndex:
+        case OpCode::SetIndex:
+            emitLea(Rdi, R12, slot(opCode == OpCode::GetIndex ? top - 1 : top - 2));
+            emitCall(reinterpret_cast<const void *>(
+                             opCode == OpCode::GetIndex ? &JitCode::getIndex : &JitCode::setIndex));
+            emit8(0x84), emit8(0xC0); // test al, al
+            emitDeopt(offset, emitJcc(Equal));
+            break;
+        case OpCode::Jump:
+            emitJumpTo(next + ((code[offset + 1] << 8) | code[offset + 2]), emitJmp());
+            break;
+        case OpCode::JumpIfTrue:
+        case OpCode::JumpIfFalse:
+        case OpCode::PopJumpIfFalse: {
+            // popping only moves the depth the next instruction is compiled for
+            int target = next + ((code[offset + 1] << 8) | code[offset + 2]);
+            // falsey is nil or false, everything else is truthy
+            emitCmpImm8(R12, slot(top) + TYPE, static_cast<int8_t>(typeTag(ValueType::Nil)));
+            int nilJump = emitJcc(Equal);
+            emitCmpImm8(R12, slot(top) + TYPE, static_cast<int8_t>(typeTag(ValueType::Bool)));
+            int notBoolJump = emitJcc(NotEqual);
+            emitCmpByteImm8(R12, slot(top) + PAYLOAD, 0);
+            if (opCode != OpCode::JumpIfTrue) {
+                emitJumpTo(target, emitJcc(Equal));
+                emitJumpTo(target, nilJump);
+                patch32(notBoolJump, static_cast<int>(_buf.size()));
+            } else {
+                emitJumpTo(target, emitJcc(NotEqual));
+                emitJumpTo(target, notBoolJump);
+                patch32(nilJump, static_cast<int>(_buf.size()));
+            }
+            break;
+        }
+        case OpCode::Loop: {
+            int target = next - ((code[offset + 1] << 8) | code[offset + 2]);
+            // dec qword [r14], out of budget hands the loop head back to the interpreter
+            emitRex(true, 1, R14);
+            emit8(0xFF);
+            emitMem(1, R14, 0);
+            emitDeopt(target, emitJcc(LessEqual));
+            emitJumpTo(target, emitJmp());
+            break;
+        }
+        case OpCode::Call:
+        case OpCode::Return:
+        case OpCode::Yield:
+            // let the interpreter call out, tear down the frame or switch fibers
+            emitDeopt(offset, emitJmp());
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void JitAssembler::emit32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        emit8((value >> (i * 8)) & 0xFF);
+    }
+}
+
+void JitAssembler::emit64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        emit8((value >> (i * 8)) & 0xFF);
+    }
+}
+
+void JitAssembler::patch32(int position, int target) {
+    auto rel = static_cast<uint32_t>(target - (position + 4));
+    for (int i = 0; i < 4; i++) {
+        _buf[position + i] = (rel >> (i * 8)) & 0xFF;
+    }
+}
+
+void JitAssembler::emitRex(bool wide, int reg, int base) {
+    uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) << 2) | (base >> 3);
+    if (rex != 0x40) emit8(rex);
+}
+
+void JitAssembler::emitMem(int reg, int base, int32_t disp) {
+    // always [base + disp32], r12 as a base needs a sib byte
+    emit8(0x80 | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == 4) emit8(0x24);
+    emit32(disp);
+}
+
+void JitAssembler::emitSse(uint8_t prefix, uint8_t op, int xmm, int base, int32_t disp) {
+    emit8(prefix);
+    emitRex(false, xmm, base);
+    emit8(0x0F), emit8(op);
+    emitMem(xmm, base, disp);
+}
+
+void JitAssembler::emitStoreImm32(int base, int32_t disp, int32_t imm) {
+    emitRex(false, 0, base);
+    emit8(0xC7);
+    emitMem(0, base, disp);
+    emit32(imm);
+}
+
+void JitAssembler::emitStoreImm64(int base, int32_t disp, int32_t imm) {
+    emitRex(true, 0, base);
+    emit8(0xC7);
+    emitMem(0, base, disp);
+    emit32(imm);
+}
+
+void JitAssembler::emitCmpImm8(int base, int32_t disp, int8_t imm) {
+    emitRex(false, 7, base);
+    emit8(0x83);
+    emitMem(7, base, disp);
+    emit8(imm);
+}
+
+void JitAssembler::emitCmpByteImm8(int base, int32_t disp, int8_t imm) {
+    emitRex(false, 7, base);
+    emit8(0x80);
+    emitMem(7, base, disp);
+    emit8(imm);
+}
+
+void JitAssembler::emitLea(int reg, int base, int32_t disp) {
+    emitRex(true, reg, base);
+    emit8(0x8D);
+    emitMem(reg, base, disp);
+}
+
+void JitAssembler::emitMovImm64(int reg, uint64_t imm) {
+    emitRex(true, 0, reg);
+    emit8(0xB8 + (reg & 7));
+    emit64(imm);
+}
+
+int JitAssembler::emitJcc(Cond cond) {
+    emit8(0x0F), emit8(0x80 | cond);
+    int position = static_cast<int>(_buf.size());
+    emit32(0);
+    return position;
+}
+
+int JitAssembler::emitJmp() {
+    emit8(0xE9);
+    int position = static_cast<int>(_buf.size());
+    emit32(0);
+    return position;
+}
+
+void JitAssembler::emitCall(const void *function) {
+    emitMovImm64(Rax, reinterpret_cast<uint64_t>(function));
+    emit8(0xFF), emit8(0xD0); // call rax
+}
+
+void JitAssembler::emitCopy(int fromBase, int32_t fromDisp, int32_t toDisp) {
+    emitSse(0xF3, 0x6F, 0, fromBase, fromDisp); // movdqu xmm0, from
+    emitSse(0xF3, 0x7F, 0, R12, toDisp); // movdqu to, xmm0
+}
+
+void JitAssembler::emitStoreBool(int index, Cond cond) {
+    emit8(0x0F), emit8(0x90 | cond), emit8(0xC0); // setcc al
+    emit8(0x0F), emit8(0xB6), emit8(0xC0); // movzx eax, al
+    emitStoreImm32(R12, slot(index) + TYPE, typeTag(ValueType::Bool));
+    // mov qword [r12 + disp], rax
+    emitRex(true, Rax, R12);
+    emit8(0x89);
+    emitMem(Rax, R12, slot(index) + PAYLOAD);
+}
+
+void JitAssembler::emitJumpTo(int target, int position) {
+    _jumpFixups.emplace_back(position, target);
+}
+
+void JitAssembler::emitDeopt(int offset, int position) {
+    _deoptFixups.emplace_back(position, offset);
+}
+
+void JitAssembler::emitGuardNumber(int index, int offset) {
+    emitCmpImm8(R12, slot(index) + TYPE, static_cast<int8_t>(typeTag(ValueType::Number)));
+    emitDeopt(offset, emitJcc(NotEqual));
+}
+
+JitCode *JitCode::compile(const Chunk &chunk, int arity) {
+#ifdef CPPLOX_JIT_SUPPORTED
+    auto jit = new JitCode;
+    JitAssembler assembler(chunk, arity, *jit);
+    if (!assembler.assemble()) {
+        delete jit;
+        return nullptr;
+    }
+
+    const std::vector<uint8_t> &buf = assembler.buffer();
+    void *memory = mmap(nullptr, buf.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        delete jit;
+        return nullptr;
+    }
+    memcpy(memory, buf.data(), buf.size());
+    if (mprotect(memory, buf.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, buf.size());
+        delete jit;
+        return nullptr;
+    }
+
+    jit->_code = static_cast<uint8_t *>(memory);
+    jit->_size = buf.size();
+    return jit;
+#else
+    (void) chunk;
+    (void) arity;
+    return nullptr;
+#endif
+}
+
+JitCode::~JitCode() {
+#ifdef CPPLOX_JIT_SUPPORTED
+    if (_code != nullptr) munmap(_code, _size);
+#endif
+}
+
+int JitCode::run(VM *vm, Value *slots, const Value *constants, int offset, int64_t *budget) const {
+    using Entry = int (*)(VM *, Value *, const Value *, const void *, int64_t *);
+    auto entry = reinterpret_cast<Entry>(_code);
+    return entry(vm, slots, constants, _code + _entries[offset], budget);
+}
+
+bool JitCode::getGlobal(VM *vm, Value *slot, const Value *name) {
+    return vm->_globals.get(*name, slot);
+}
+
+void JitCode::defineGlobal(VM *vm, Value *slot, const Value *name) {
+    vm->_globals.set(*name, *slot);
+}
+
+bool JitCode::setGlobal(VM *vm, Value *slot, const Value *name) {
+    Value value;
+    if (!vm->_globals.get(*name, &value)) return false;
+    vm->_globals.set(*name, *slot);
+    return true;
+}
+
+void JitCode::equal(Value *slots) {
+    slots[0] = Value(slots[0] == slots[1]);
+}
+
+void JitCode::notEqual(Value *slots) {
+    slots[0] = Value(slots[0] != slots[1]);
+}
+
+void JitCode::logicalNot(Value *slot) {
+    *slot = Value(slot->isFalsey());
+}
+
+void JitCode::print(VM *vm, Value *slot) {
+    vm->_output.writeValue(*slot);
+    vm->_output.put('\n');
+}
+
+void JitCode::buildList(VM *vm, Value *slots, int count) {
+    auto list = new ObjList(*vm);
+    list->reserve(count);
+    for (int i = 0; i < count; i++) {
+        list->append(slots[i]);
+    }
+    slots[0] = Value(list);
+}
+
+// slices and concatenated strings need the vm to be interned before they can be keys
+static inline bool interned(const Value &key) {
+    if (key.isSlice()) return false;
+    return !key.isString() || key.asString()->interned();
+}
+
+bool JitCode::buildMap(VM *vm, Value *slots, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!ObjMap::validKey(slots[2 * i]) || !interned(slots[2 * i])) return false;
+    }
+    auto map = new ObjMap(*vm);
+    map->table.setAll(slots, count);
+    slots[0] = Value(map);
+    return true;
+}
+
+bool JitCode::getIndex(Value *slots) {
+    if (slots[0].isMap()) {
+        if (!ObjMap::validKey(slots[1]) || !interned(slots[1])) return false;
+        Value element;
+        if (!slots[0].asMap()->table.get(slots[1], &element)) element = Value();
+        slots[0] = element;
+        return true;
+    }
+
+    int index;
+    if (!slots[0].isList() || !slots[1].isNumber() || !slots[0].asList()->index(slots[1].asNumber(), index)) {
+        return false;
+    }
+    slots[0] = slots[0].asList()->get(index);
+    return true;
+}
+
+bool JitCode::setIndex(Value *slots) {
+    if (slots[0].isMap()) {
+        if (!ObjMap::validKey(slots[1]) || !interned(slots[1])) return false;
+        slots[0].asMap()->table.set(slots[1], slots[2]);
+        slots[0] = slots[2];
+        return true;
+    }
+
+    int index;
+    if (!slots[0].isList() || !slots[1].isNumber() || !slots[0].asList()->index(slots[1].asNumber(), index)) {
+        return false;
+    }
+    slots[0].asList()->set(index, slots[2]);
+    slots[0] = slots[2];
+    return true;
+}
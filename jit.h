@@ -0,0 +1,77 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_JIT_H
+#define CPPLOX_JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "non_copyable.h"
+
+class Chunk;
+
+class Value;
+
+class VM;
+
+// baseline template jit, stitches one machine code template per instruction
+// only available on x86-64 linux, compile() returns nullptr everywhere else
+class JitCode : NonCopyable {
+public:
+    // arity says how many argument slots sit above the callee when the chunk starts
+    static JitCode *compile(const Chunk &chunk, int arity = 0);
+
+    ~JitCode();
+
+    [[nodiscard]] inline bool canEnter(int offset) const { return _entries[offset] >= 0; }
+
+    [[nodiscard]] inline int stackDepth(int offset) const { return _stackDepths[offset]; }
+
+    [[nodiscard]] inline int maxStackDepth() const { return _maxStackDepth; }
+
+    // runs from the instruction at offset until a guard fails, the chunk returns or budget runs out,
+    // every backward jump takes one from budget,
+    // returns the offset of the instruction the interpreter should resume from
+    int run(VM *vm, Value *slots, const Value *constants, int offset, int64_t *budget) const;
+
+private:
+    friend class JitAssembler;
+
+    JitCode() = default;
+
+    static bool getGlobal(VM *vm, Value *slot, const Value *name);
+
+    static void defineGlobal(VM *vm, Value *slot, const Value *name);
+
+    static bool setGlobal(VM *vm, Value *slot, const Value *name);
+
+    static void equal(Value *slots);
+
+    static void notEqual(Value *slots);
+
+    static void logicalNot(Value *slot);
+
+    static void print(VM *vm, Value *slot);
+
+    // slots starts at the first element, the list replaces it
+    static void buildList(VM *vm, Value *slots, int count);
+
+    // slots starts at the first key, false if one of them can't be a key
+    static bool buildMap(VM *vm, Value *slots, int count);
+
+    // slots starts at the list or map, false leaves the error for the interpreter to report
+    static bool getIndex(Value *slots);
+
+    static bool setIndex(Value *slots);
+
+    uint8_t *_code = nullptr;
+    size_t _size = 0;
+    std::vector<int> _entries;
+    std::vector<int> _stackDepths;
+    int _maxStackDepth = 0;
+};
+
+#endif //CPPLOX_JIT_H
@@ -1,16 +1,22 @@
+#include "event_loop.h"
+#include "repl.h"
+#include "script_runner.h"
 #include "vm.h"
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
-static void repl() {
-    VM &vm = VM::instance();
+static void repl(VM &vm) {
+    Repl session(vm);
+    std::string line;
     while (std::cin) {
         printf("> ");
-        std::string line;
         std::getline(std::cin, line);
-        vm.interpret(line.c_str());
+        session.interpret(line.c_str());
+        vm.output().flush();
     }
 }
 
@@ -21,21 +27,97 @@ static std::string readFile(const std::string &path) {
     return buffer.str();
 }
 
-static void runFile(const std::string &path) {
+// the script runs as the loop's first fiber so its i/o natives don't block the process
+static VM::InterpretResult runFile(VM &vm, EventLoop &loop, const std::string &path) {
     std::string source = readFile(path);
-    VM::InterpretResult result = VM::instance().interpret(source.c_str());
-    if (result == VM::InterpretResult::CompileError) exit(65);
-    if (result == VM::InterpretResult::RuntimeError) exit(70);
+    ObjFunction *function = vm.compile(source.c_str());
+    if (function == nullptr) return VM::InterpretResult::CompileError;
+
+    loop.spawn(function);
+    return loop.run() ? VM::InterpretResult::Ok : VM::InterpretResult::RuntimeError;
+}
+
+// output stays in script order, the first failing script decides the result
+static VM::InterpretResult runFiles(const std::vector<std::string> &paths, int jobs, bool jit) {
+    std::vector<std::string> sources;
+    for (const std::string &path: paths) {
+        sources.push_back(readFile(path));
+    }
+
+    VM::InterpretResult result = VM::InterpretResult::Ok;
+    runScripts(sources, jobs, jit, [&result](size_t, const ScriptResult &script) {
+        fwrite(script.output.data(), 1, script.output.size(), stdout);
+        fflush(stdout);
+        fwrite(script.errors.data(), 1, script.errors.size(), stderr);
+        if (result == VM::InterpretResult::Ok) result = script.result;
+    });
+    return result;
+}
+
+static void usage() {
+    fprintf(stderr, "Usage cpplox [--jit] [--optimize] [--compile-jobs N] [--profile[=folded path]] [path]\n");
+    fprintf(stderr, "      cpplox [--jit] --jobs N path...\n");
+    exit(64);
 }
 
 int main(int argc, const char *argv[]) {
-    if (argc == 1) {
-        repl();
-    } else if (argc == 2) {
-        runFile(argv[1]);
+    VM vm;
+    EventLoop loop(vm);
+    Profiler profiler;
+    const char *foldedPath = nullptr;
+    bool jit = false;
+    int jobs = 0;
+
+    int argi = 1;
+    for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; argi++) {
+        if (strcmp(argv[argi], "--jit") == 0) {
+            jit = true;
+            vm.setJitEnabled(true);
+        } else if (strcmp(argv[argi], "--optimize") == 0) {
+            vm.setOptimizing(true);
+        } else if (strcmp(argv[argi], "--compile-jobs") == 0 && argi + 1 < argc) {
+            int compileJobs = atoi(argv[++argi]);
+            if (compileJobs < 1) usage();
+            vm.setCompileJobs(compileJobs);
+        } else if (strcmp(argv[argi], "--jobs") == 0 && argi + 1 < argc) {
+            jobs = atoi(argv[++argi]);
+            if (jobs < 1) usage();
+        } else if (strcmp(argv[argi], "--profile") == 0) {
+            foldedPath = "cpplox.folded";
+        } else if (strncmp(argv[argi], "--profile=", 10) == 0) {
+            foldedPath = argv[argi] + 10;
+        } else {
+            usage();
+        }
+    }
+
+    if (foldedPath != nullptr) {
+        vm.setProfiler(&profiler);
+    }
+
+    VM::InterpretResult result = VM::InterpretResult::Ok;
+    if (jobs > 0) {
+        // the profiler isn't thread safe
+        if (argi == argc || foldedPath != nullptr) usage();
+        result = runFiles(std::vector<std::string>(argv + argi, argv + argc), jobs, jit);
+    } else if (argi == argc) {
+        repl(vm);
+    } else if (argi + 1 == argc) {
+        result = runFile(vm, loop, argv[argi]);
     } else {
-        fprintf(stderr, "Usage cpplox [path]\n");
-        exit(64);
+        usage();
     }
+
+    if (foldedPath != nullptr) {
+        profiler.report(stderr);
+        if (!profiler.writeFolded(foldedPath)) {
+            fprintf(stderr, "Could not write profile to '%s'.\n", foldedPath);
+        }
+    }
+
+    // exit skips the vm's destructor
+    vm.output().flush();
+    if (result == VM::InterpretResult::CompileError) exit(65);
+    if (result == VM::InterpretResult::RuntimeError) exit(70);
     return 0;
 }
@@ -0,0 +1,444 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "natives.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "number.h"
+#include "object.h"
+#include "output_buffer.h"
+#include "vm.h"
+
+static NativeResult toStringNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1) {
+        vm.runtimeError("tostring() expects 1 argument but got %d.", argCount);
+        return NativeResult::Error;
+    }
+
+    if (args[0].isString() || args[0].isShortString()) {
+        args[-1] = args[0];
+    } else if (args[0].isSlice()) {
+        args[-1] = Value(args[0].asSlice()->intern(vm));
+    } else if (args[0].isStringBuilder()) {
+        // the only point where a builder's text gets interned
+        const std::string &text = args[0].asStringBuilder()->text();
+        args[-1] = Value(vm, text.data(), static_cast<int>(text.size()));
+    } else if (args[0].isNumber()) {
+        char digits[NUMBER_MAX_LENGTH];
+        args[-1] = Value(vm, digits, formatNumber(args[0].asNumber(), digits));
+    } else {
+        std::string text;
+        OutputBuffer buffer(64);
+        buffer.setSink(OutputBuffer::stringSink(text));
+        buffer.writeValue(args[0]);
+        buffer.flush();
+        args[-1] = Value(vm, text.data(), static_cast<int>(text.size()));
+    }
+    return NativeResult::Ok;
+}
+
+static NativeResult numNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1) {
+        vm.runtimeError("num() expects 1 argument but got %d.", argCount);
+        return NativeResult::Error;
+    }
+
+    double number;
+    if (args[0].isNumber()) {
+        args[-1] = args[0];
+    } else if (args[0].isText() && parseNumber(args[0].asText().data(), static_cast<int>(args[0].asText().size()),
+                                               number)) {
+        args[-1] = Value(number);
+    } else {
+        args[-1] = Value();
+    }
+    return NativeResult::Ok;
+}
+
+static NativeResult lenNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1 || !(args[0].isList() || args[0].isMap() || args[0].isText() || args[0].isStringBuilder())) {
+        vm.runtimeError("len() expects a list, a map, a string or a string builder.");
+        return NativeResult::Error;
+    }
+
+    int length;
+    if (args[0].isList()) {
+        length = args[0].asList()->count();
+    } else if (args[0].isMap()) {
+        length = args[0].asMap()->table.size();
+    } else if (args[0].isStringBuilder()) {
+        length = static_cast<int>(args[0].asStringBuilder()->text().size());
+    } else {
+        length = static_cast<int>(args[0].asText().size());
+    }
+    args[-1] = Value(static_cast<double>(length));
+    return NativeResult::Ok;
+}
+
+static NativeResult pushNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 2 || !args[0].isList()) {
+        vm.runtimeError("push() expects a list and a value.");
+        return NativeResult::Error;
+    }
+
+    args[0].asList()->append(args[1]);
+    args[-1] = args[0];
+    return NativeResult::Ok;
+}
+
+// the kernels below take four numbers a step in two sse2 registers, gcc and clang emit packed
+// instructions for them even without optimization, so sums may round differently than a left to right loop in lox
+#if defined(__GNUC__)
+typedef double Lanes __attribute__((vector_size(2 * sizeof(double))));
+
+static inline Lanes loadLanes(const double *numbers) {
+    Lanes lanes;
+    memcpy(&lanes, numbers, sizeof(lanes));
+    return lanes;
+}
+
+static inline void storeLanes(double *numbers, Lanes lanes) {
+    memcpy(numbers, &lanes, sizeof(lanes));
+}
+
+static inline double sumLanes(Lanes a, Lanes b) {
+    Lanes lanes = a + b;
+    return lanes[0] + lanes[1];
+}
+#endif
+
+static double sumNumbers(const double *numbers, int count) {
+    int i = 0;
+    double sum = 0;
+#if defined(__GNUC__)
+    Lanes low{}, high{};
+    for (; i + 4 <= count; i += 4) {
+        low += loadLanes(numbers + i);
+        high += loadLanes(numbers + i + 2);
+    }
+    sum = sumLanes(low, high);
+#endif
+    for (; i < count; i++) {
+        sum += numbers[i];
+    }
+    return sum;
+}
+
+static double dotNumbers(const double *a, const double *b, int count) {
+    int i = 0;
+    double sum = 0;
+#if defined(__GNUC__)
+    Lanes low{}, high{};
+    for (; i + 4 <= count; i += 4) {
+        low += loadLanes(a + i) * loadLanes(b + i);
+        high += loadLanes(a + i + 2) * loadLanes(b + i + 2);
+    }
+    sum = sumLanes(low, high);
+#endif
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static void scaleNumbers(double *numbers, int count, double factor) {
+    int i = 0;
+#if defined(__GNUC__)
+    for (; i + 4 <= count; i += 4) {
+        storeLanes(numbers + i, loadLanes(numbers + i) * factor);
+        storeLanes(numbers + i + 2, loadLanes(numbers + i + 2) * factor);
+    }
+#endif
+    for (; i < count; i++) {
+        numbers[i] *= factor;
+    }
+}
+
+// points numbers at the list's doubles, a list that once held something else is unboxed into scratch,
+// false unless value is a list of nothing but numbers
+static bool numbersOf(const Value &value, std::vector<double> &scratch, const double *&numbers) {
+    if (!value.isList()) return false;
+
+    const ObjList *list = value.asList();
+    if (list->numeric()) {
+        numbers = list->numbers();
+        return true;
+    }
+
+    scratch.resize(list->count());
+    for (int i = 0; i < list->count(); i++) {
+        Value element = list->get(i);
+        if (!element.isNumber()) return false;
+        scratch[i] = element.asNumber();
+    }
+    numbers = scratch.data();
+    return true;
+}
+
+static NativeResult sumNative(VM &vm, void *, int argCount, Value *args) {
+    std::vector<double> scratch;
+    const double *numbers;
+    if (argCount != 1 || !numbersOf(args[0], scratch, numbers)) {
+        vm.runtimeError("sum() expects a list of numbers.");
+        return NativeResult::Error;
+    }
+
+    args[-1] = Value(sumNumbers(numbers, args[0].asList()->count()));
+    return NativeResult::Ok;
+}
+
+static NativeResult dotNative(VM &vm, void *, int argCount, Value *args) {
+    std::vector<double> scratchA, scratchB;
+    const double *a, *b;
+    if (argCount != 2 || !numbersOf(args[0], scratchA, a) || !numbersOf(args[1], scratchB, b)
+        || args[0].asList()->count() != args[1].asList()->count()) {
+        vm.runtimeError("dot() expects two lists of numbers of the same length.");
+        return NativeResult::Error;
+    }
+
+    args[-1] = Value(dotNumbers(a, b, args[0].asList()->count()));
+    return NativeResult::Ok;
+}
+
+// scales the list in place and returns it
+static NativeResult scaleNative(VM &vm, void *, int argCount, Value *args) {
+    std::vector<double> scratch;
+    const double *numbers;
+    if (argCount != 2 || !numbersOf(args[0], scratch, numbers) || !args[1].isNumber()) {
+        vm.runtimeError("scale() expects a list of numbers and a number.");
+        return NativeResult::Error;
+    }
+
+    ObjList *list = args[0].asList();
+    double factor = args[1].asNumber();
+    if (list->numeric()) {
+        scaleNumbers(list->numbers(), list->count(), factor);
+    } else {
+        for (int i = 0; i < list->count(); i++) {
+            list->set(i, Value(scratch[i] * factor));
+        }
+    }
+    args[-1] = args[0];
+    return NativeResult::Ok;
+}
+
+static bool checkMapArgs(VM &vm, const char *name, int argCount, const Value *args) {
+    if (argCount != 2 || !args[0].isMap()) {
+        vm.runtimeError("%s() expects a map and a key.", name);
+        return false;
+    }
+    return true;
+}
+
+static NativeResult hasNative(VM &vm, void *, int argCount, Value *args) {
+    if (!checkMapArgs(vm, "has", argCount, args)) return NativeResult::Error;
+
+    Value value;
+    args[-1] = Value(ObjMap::validKey(args[1]) && args[0].asMap()->table.get(vm.mapKey(args[1]), &value));
+    return NativeResult::Ok;
+}
+
+static NativeResult removeNative(VM &vm, void *, int argCount, Value *args) {
+    if (!checkMapArgs(vm, "remove", argCount, args)) return NativeResult::Error;
+
+    args[-1] = Value(ObjMap::validKey(args[1]) && args[0].asMap()->table.remove(vm.mapKey(args[1])));
+    return NativeResult::Ok;
+}
+
+static NativeResult keysNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1 || !args[0].isMap()) {
+        vm.runtimeError("keys() expects a map.");
+        return NativeResult::Error;
+    }
+
+    const Table &table = args[0].asMap()->table;
+    auto keys = new ObjList(vm);
+    keys->reserve(table.size());
+    int index = 0;
+    Value key, value;
+    while (table.next(index, key, value)) {
+        keys->append(key);
+    }
+    args[-1] = Value(keys);
+    return NativeResult::Ok;
+}
+
+// a view of text's characters start to start + length, the string itself when that's all of it,
+// pieces that fit in a short string are copied into one
+static Value slice(VM &vm, const Value &text, int start, int length) {
+    if (length <= Value::SHORT_STRING_MAX) return Value(vm, text.asText().data() + start, length);
+
+    ObjString *string;
+    if (text.isSlice()) {
+        string = text.asSlice()->string();
+        start += text.asSlice()->start();
+    } else {
+        string = text.asString();
+    }
+
+    if (start == 0 && length == string->length()) return Value(string);
+    return Value(new ObjSlice(vm, string, start, length));
+}
+
+static bool wholeNumber(const Value &value) {
+    return value.isNumber() && fitsInt(value.asNumber());
+}
+
+static NativeResult substrNative(VM &vm, void *, int argCount, Value *args) {
+    if ((argCount != 2 && argCount != 3) || !args[0].isText() || !wholeNumber(args[1])
+        || (argCount == 3 && !wholeNumber(args[2]))) {
+        vm.runtimeError("substr() expects a string, a start and an optional length.");
+        return NativeResult::Error;
+    }
+
+    int size = static_cast<int>(args[0].asText().size());
+    int start = static_cast<int>(args[1].asNumber());
+    int length = argCount == 3 ? static_cast<int>(args[2].asNumber()) : size - start;
+    if (start < 0 || length < 0 || start > size || length > size - start) {
+        vm.runtimeError("substr() range is out of bounds.");
+        return NativeResult::Error;
+    }
+
+    args[-1] = slice(vm, args[0], start, length);
+    return NativeResult::Ok;
+}
+
+static NativeResult splitNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 2 || !args[0].isText() || !args[1].isText() || args[1].asText().empty()) {
+        vm.runtimeError("split() expects a string and a non-empty separator.");
+        return NativeResult::Error;
+    }
+
+    std::string_view text = args[0].asText();
+    std::string_view separator = args[1].asText();
+    auto parts = new ObjList(vm);
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find(separator, start);
+        if (end == std::string_view::npos) end = text.size();
+        parts->append(slice(vm, args[0], static_cast<int>(start), static_cast<int>(end - start)));
+        if (end == text.size()) break;
+        start = end + separator.size();
+    }
+    args[-1] = Value(parts);
+    return NativeResult::Ok;
+}
+
+static NativeResult findNative(VM &vm, void *, int argCount, Value *args) {
+    if ((argCount != 2 && argCount != 3) || !args[0].isText() || !args[1].isText()
+        || (argCount == 3 && !wholeNumber(args[2]))) {
+        vm.runtimeError("find() expects a string, a string to look for and an optional start.");
+        return NativeResult::Error;
+    }
+
+    std::string_view text = args[0].asText();
+    double from = argCount == 3 ? args[2].asNumber() : 0;
+    size_t index = from < 0 ? std::string_view::npos : text.find(args[1].asText(), static_cast<size_t>(from));
+    args[-1] = Value(index == std::string_view::npos ? -1.0 : static_cast<double>(index));
+    return NativeResult::Ok;
+}
+
+static NativeResult startsWithNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 2 || !args[0].isText() || !args[1].isText()) {
+        vm.runtimeError("startsWith() expects two strings.");
+        return NativeResult::Error;
+    }
+
+    std::string_view text = args[0].asText();
+    std::string_view prefix = args[1].asText();
+    args[-1] = Value(text.substr(0, prefix.size()) == prefix);
+    return NativeResult::Ok;
+}
+
+static NativeResult builderNative(VM &vm, void *, int argCount, Value *args) {
+    auto builder = new ObjStringBuilder(vm);
+    for (int i = 0; i < argCount; i++) {
+        builder->append(args[i]);
+    }
+    args[-1] = Value(builder);
+    return NativeResult::Ok;
+}
+
+static NativeResult appendNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount < 1 || !args[0].isStringBuilder()) {
+        vm.runtimeError("append() expects a string builder and the values to append.");
+        return NativeResult::Error;
+    }
+
+    ObjStringBuilder *builder = args[0].asStringBuilder();
+    for (int i = 1; i < argCount; i++) {
+        builder->append(args[i]);
+    }
+    args[-1] = args[0];
+    return NativeResult::Ok;
+}
+
+static NativeResult fiberNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1 || !args[0].isFunction() || args[0].asFunction()->arity != 0) {
+        vm.runtimeError("fiber() expects a function that takes no arguments.");
+        return NativeResult::Error;
+    }
+
+    args[-1] = Value(new ObjFiber(vm, vm.spawn(args[0].asFunction())));
+    return NativeResult::Ok;
+}
+
+static NativeResult resumeNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1 || !args[0].isFiber()) {
+        vm.runtimeError("resume() expects a fiber.");
+        return NativeResult::Error;
+    }
+
+    Fiber &fiber = args[0].asFiber()->fiber();
+    if (fiber.state() != Fiber::State::Suspended) {
+        vm.runtimeError("Can only resume a suspended fiber.");
+        return NativeResult::Error;
+    }
+
+    VM::InterpretResult result = vm.resume(fiber);
+    // the fiber already reported its error, the script stops with it
+    if (result == VM::InterpretResult::RuntimeError) return NativeResult::Error;
+    // it used up the script's budget, resuming the script resumes the fiber where it stopped
+    if (result == VM::InterpretResult::Suspended) return NativeResult::Suspend;
+    // nil when a host native left it blocked
+    bool finished = result == VM::InterpretResult::Yielded || result == VM::InterpretResult::Ok;
+    args[-1] = finished ? fiber.yielded() : Value();
+    return NativeResult::Ok;
+}
+
+static NativeResult doneNative(VM &vm, void *, int argCount, Value *args) {
+    if (argCount != 1 || !args[0].isFiber()) {
+        vm.runtimeError("done() expects a fiber.");
+        return NativeResult::Error;
+    }
+
+    args[-1] = Value(args[0].asFiber()->fiber().state() == Fiber::State::Done);
+    return NativeResult::Ok;
+}
+
+void defineCoreNatives(VM &vm) {
+    vm.defineNative("tostring", toStringNative);
+    vm.defineNative("num", numNative);
+    vm.defineNative("len", lenNative);
+    vm.defineNative("push", pushNative);
+    vm.defineNative("sum", sumNative);
+    vm.defineNative("dot", dotNative);
+    vm.defineNative("scale", scaleNative);
+    vm.defineNative("has", hasNative);
+    vm.defineNative("remove", removeNative);
+    vm.defineNative("keys", keysNative);
+    vm.defineNative("substr", substrNative);
+    vm.defineNative("split", splitNative);
+    vm.defineNative("find", findNative);
+    vm.defineNative("startsWith", startsWithNative);
+    vm.defineNative("builder", builderNative);
+    vm.defineNative("append", appendNative);
+    vm.defineNative("fiber", fiberNative);
+    vm.defineNative("resume", resumeNative);
+    vm.defineNative("done", doneNative);
+}
@@ -0,0 +1,35 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_NATIVES_H
+#define CPPLOX_NATIVES_H
+
+#include "forward.h"
+
+// natives every vm starts with:
+//   tostring(value) -> the text print would show, for a string builder its text as an interned string
+//   num(value) -> the number a string spells, nil if it doesn't spell one
+//   len(list, map, string or builder) -> number of elements, entries or characters
+//   push(list, value) -> list, with value appended
+//   sum(list) -> sum of a list of numbers
+//   dot(a, b) -> dot product of two lists of numbers of the same length
+//   scale(list, factor) -> list, every number in it multiplied by factor
+//   has(map, key) -> whether key is in map
+//   remove(map, key) -> whether key was in map
+//   keys(map) -> list of map's keys, in no particular order
+// the string natives hand out slices that share the characters of the string they were cut from:
+//   substr(string, start, length) -> length characters from start, the rest of the string without length
+//   split(string, separator) -> list of the pieces between separators
+//   find(string, needle, from) -> index of the first needle at or after from, -1 if there is none
+//   startsWith(string, prefix) -> whether string begins with prefix
+// a string builder collects text without interning any of it:
+//   builder(values...) -> a new builder holding the values' text
+//   append(builder, values...) -> builder, with the text of each value added the way print shows it
+// a fiber runs inside the resume that resumed it, which may be called from another fiber:
+//   fiber(function) -> a new fiber that will call function, which takes no arguments, when first resumed
+//   resume(fiber) -> what the fiber yields next, or what its function returns
+//   done(fiber) -> whether the fiber's function has returned
+void defineCoreNatives(VM &vm);
+
+#endif //CPPLOX_NATIVES_H
@@ -0,0 +1,71 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "number.h"
+
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+// every power of ten a double holds exactly
+static constexpr double EXACT_POWERS_OF_TEN[]{
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static constexpr uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+
+static bool parseSlow(const char *chars, int length, double &result) {
+    auto [end, error] = std::from_chars(chars, chars + length, result);
+    return error == std::errc() && end == chars + length;
+}
+
+bool parseNumber(const char *chars, int length, double &result) {
+    // digits with an optional fraction, which is everything a literal can be
+    const char *p = chars;
+    const char *end = chars + length;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction = 0;
+    const char *start = p;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p == start) return parseSlow(chars, length, result);
+    if (p < end && *p == '.') {
+        p++;
+        for (; p < end && *p >= '0' && *p <= '9'; p++, digits++, fraction++) {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        if (fraction == 0) return parseSlow(chars, length, result);
+    }
+
+    // clinger: an exact mantissa divided by an exact power of ten rounds correctly in one step
+    if (p != end || digits > 19 || mantissa > MAX_EXACT_MANTISSA || fraction > 22) {
+        return parseSlow(chars, length, result);
+    }
+
+    double value = static_cast<double>(mantissa) / EXACT_POWERS_OF_TEN[fraction];
+    result = negative ? -value : value;
+    return true;
+}
+
+bool fitsInt(double number) {
+    return std::isfinite(number) && number >= INT_MIN && number <= INT_MAX && number == std::trunc(number);
+}
+
+int formatNumber(double number, char *buffer) {
+    char *end;
+    // most numbers scripts deal with are integers, those skip the general algorithm
+    if (number == std::trunc(number) && std::fabs(number) < 1e15 && !(number == 0 && std::signbit(number))) {
+        end = std::to_chars(buffer, buffer + NUMBER_MAX_LENGTH, static_cast<int64_t>(number)).ptr;
+    } else {
+        end = std::to_chars(buffer, buffer + NUMBER_MAX_LENGTH, number).ptr;
+    }
+    return static_cast<int>(end - buffer);
+}
@@ -0,0 +1,23 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_NUMBER_H
+#define CPPLOX_NUMBER_H
+
+// locale independent conversions between doubles and text, shared by the compiler, print and natives
+
+// longest text formatNumber writes
+constexpr int NUMBER_MAX_LENGTH = 32;
+
+// parses all of chars, false if it isn't a number
+bool parseNumber(const char *chars, int length, double &result);
+
+// a whole number in int range, check it before casting since a double outside the range doesn't convert
+bool fitsInt(double number);
+
+// integers as plain digits, anything else as the shortest text that parses back to the same double,
+// returns the length written to buffer, which isn't terminated
+int formatNumber(double number, char *buffer);
+
+#endif //CPPLOX_NUMBER_H
@@ -4,27 +4,52 @@
 
 #include "object.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "jit.h"
+#include "number.h"
+#include "output_buffer.h"
+#include "string_space.h"
 #include "vm.h"
 
-Obj::Obj(ObjType type, bool manualAddToVM) : type(type) {
+Obj::Obj(ObjType type, VM &vm, bool manualAddToVM) : type(type) {
     if (!manualAddToVM) {
-        addToVM();
+        addToVM(vm);
     }
 }
 
-void Obj::addToVM() {
-    auto &objects = VM::instance().objects();
+void Obj::addToVM(VM &vm) {
+    auto &objects = vm.objects();
     next = objects;
     objects = this;
 }
 
-void Obj::print() const {
+void Obj::print(FILE *out) const {
     switch (type) {
         case ObjType::String:
-            reinterpret_cast<const ObjString *>(this)->doPrint();
+            reinterpret_cast<const ObjString *>(this)->doPrint(out);
             break;
         case ObjType::Function:
-            reinterpret_cast<const ObjFunction *>(this)->doPrint();
+            reinterpret_cast<const ObjFunction *>(this)->doPrint(out);
+            break;
+        case ObjType::Native:
+            reinterpret_cast<const ObjNative *>(this)->doPrint(out);
+            break;
+        case ObjType::List:
+            reinterpret_cast<const ObjList *>(this)->doPrint(out);
+            break;
+        case ObjType::Map:
+            reinterpret_cast<const ObjMap *>(this)->doPrint(out);
+            break;
+        case ObjType::Slice:
+            reinterpret_cast<const ObjSlice *>(this)->doPrint(out);
+            break;
+        case ObjType::StringBuilder:
+            reinterpret_cast<const ObjStringBuilder *>(this)->doPrint(out);
+            break;
+        case ObjType::Fiber:
+            reinterpret_cast<const ObjFiber *>(this)->doPrint(out);
             break;
     }
 }
@@ -37,51 +62,89 @@ void Obj::free(Obj *obj) {
         case ObjType::Function:
             delete reinterpret_cast<ObjFunction *>(obj);
             break;
+        case ObjType::Native:
+            delete reinterpret_cast<ObjNative *>(obj);
+            break;
+        case ObjType::List:
+            delete reinterpret_cast<ObjList *>(obj);
+            break;
+        case ObjType::Map:
+            delete reinterpret_cast<ObjMap *>(obj);
+            break;
+        case ObjType::Slice:
+            delete reinterpret_cast<ObjSlice *>(obj);
+            break;
+        case ObjType::StringBuilder:
+            delete reinterpret_cast<ObjStringBuilder *>(obj);
+            break;
+        case ObjType::Fiber:
+            delete reinterpret_cast<ObjFiber *>(obj);
+            break;
     }
 }
 
-ObjString *ObjString::create(const char *chars, int length) {
-    Table &strings = VM::instance().strings();
-
+ObjString *ObjString::create(VM &vm, const char *chars, int length) {
     uint32_t h = hash(chars, length);
-    ObjString *interned = strings.find(chars, length, h);
 
+    ObjString *interned = find(vm, chars, length, h);
     if (interned != nullptr) {
         return interned;
     }
 
-    char *buf = new char[sizeof(ObjString) + length + 1];
-    new(buf) ObjString(chars, length, h);
-    auto string = reinterpret_cast<ObjString *>(buf);
+    ObjString *string = allocate(chars, length, h);
+    string->addToVM(vm);
 
-    strings.set(string, Value());
+    vm.strings().set(Value(string), Value());
     return string;
 }
 
-ObjString *ObjString::concatenate(const ObjString *a, const ObjString *b) {
-    Table &strings = VM::instance().strings();
+ObjString *ObjString::createShared(VM &vm, const char *chars, int length) {
+    StringSpace *shared = vm.sharedStrings();
+    if (shared == nullptr) return create(vm, chars, length);
 
-    char *buf = new char[sizeof(ObjString) + a->_length + b->_length + 1];
-    new(buf) ObjString(a, b);
-    auto string = reinterpret_cast<ObjString *>(buf);
+    // one the vm already has stays, its globals are keyed by it
+    uint32_t h = hash(chars, length);
+    ObjString *interned = find(vm, chars, length, h);
+    if (interned != nullptr) return interned;
+    return shared->intern(chars, length, h);
+}
 
-    ObjString *interned = strings.find(string->chars(), string->_length, string->_hash);
+ObjString *ObjString::concatenate(VM &vm, std::string_view a, std::string_view b) {
+    char *buf = new char[sizeof(ObjString) + a.size() + b.size() + 1];
+    new(buf) ObjString(vm, a, b);
+    return reinterpret_cast<ObjString *>(buf);
+}
+
+ObjString *ObjString::intern(VM &vm) {
+    if (_interned) return this;
+
+    ObjString *interned = find(vm, chars(), _length, hash());
     if (interned != nullptr) {
-        delete[] buf;
         return interned;
     }
 
-    string->addToVM();
-    strings.set(string, Value());
-    return string;
+    _interned = true;
+    vm.strings().set(Value(this), Value());
+    return this;
+}
+
+ObjString *ObjString::find(VM &vm, const char *chars, int length, uint32_t hash) {
+    StringSpace *shared = vm.sharedStrings();
+    if (shared != nullptr) {
+        if (vm.internsShared()) return shared->intern(chars, length, hash);
+        ObjString *interned = shared->find(chars, length, hash);
+        if (interned != nullptr) return interned;
+    }
+
+    return vm.strings().find(chars, length, hash);
 }
 
 void ObjString::free(ObjString *string) {
     delete[] reinterpret_cast<char *>(string);
 }
 
-void ObjString::doPrint() const {
-    printf("%s", chars());
+void ObjString::doPrint(FILE *out) const {
+    fprintf(out, "%s", chars());
 }
 
 uint32_t ObjString::hash(const char *key, int length) {
@@ -93,27 +156,152 @@ uint32_t ObjString::hash(const char *key, int length) {
     return hash;
 }
 
+ObjString *ObjString::allocate(const char *chars, int length, uint32_t hash) {
+    char *buf = new char[sizeof(ObjString) + length + 1];
+    new(buf) ObjString(chars, length, hash);
+    return reinterpret_cast<ObjString *>(buf);
+}
+
 ObjString::ObjString(const char *chars, int length, uint32_t hash) : Obj(ObjType::String) {
     char *buf = reinterpret_cast<char *>(this) + sizeof(ObjString);
     _length = length;
     memcpy(buf, chars, length);
     buf[_length] = '\0';
     _hash = hash;
+    _hashed = true;
+    _interned = true;
 }
 
-ObjString::ObjString(const ObjString *a, const ObjString *b) : Obj(ObjType::String, true) {
+ObjString::ObjString(VM &vm, std::string_view a, std::string_view b) : Obj(ObjType::String, vm) {
     char *buf = reinterpret_cast<char *>(this) + sizeof(ObjString);
-    _length = a->_length + b->_length;
-    memcpy(buf, a->chars(), a->_length);
-    memcpy(buf + a->_length, b->chars(), b->_length);
+    _length = static_cast<int>(a.size() + b.size());
+    memcpy(buf, a.data(), a.size());
+    memcpy(buf + a.size(), b.data(), b.size());
     buf[_length] = '\0';
-    _hash = hash(buf, _length);
 }
 
-void ObjFunction::doPrint() const {
+ObjFunction::~ObjFunction() {
+    delete jitCode;
+}
+
+void ObjFunction::doPrint(FILE *out) const {
     if (name == nullptr) {
-        printf("<script>");
+        fprintf(out, "<script>");
         return;
     }
-    printf("<fn %s>", name->chars());
+    fprintf(out, "<fn %s>", name->chars());
+}
+
+void ObjNative::doPrint(FILE *out) const {
+    fprintf(out, "<native fn %s>", name->chars());
+}
+
+void ObjList::set(int index, Value value) {
+    if (_numeric && !value.isNumber()) spill();
+
+    if (_numeric) {
+        _numbers[index] = value.asNumber();
+    } else {
+        _values[index] = value;
+    }
+}
+
+void ObjList::append(Value value) {
+    if (_numeric && !value.isNumber()) spill();
+
+    if (_numeric) {
+        _numbers.push_back(value.asNumber());
+    } else {
+        _values.push_back(value);
+    }
+}
+
+void ObjList::reserve(int count) {
+    if (_numeric) {
+        _numbers.reserve(count);
+    } else {
+        _values.reserve(count);
+    }
+}
+
+bool ObjList::index(double number, int &index) const {
+    if (!(number >= 0 && number < count())) return false;
+    index = static_cast<int>(number);
+    return index == number;
+}
+
+void ObjList::doPrint(FILE *out) const {
+    fprintf(out, "[");
+    for (int i = 0; i < count(); i++) {
+        if (i > 0) fprintf(out, ", ");
+        get(i).print(out);
+    }
+    fprintf(out, "]");
+}
+
+void ObjList::spill() {
+    _values.reserve(_numbers.capacity());
+    for (double number: _numbers) {
+        _values.emplace_back(number);
+    }
+    _numbers = std::vector<double>();
+    _numeric = false;
+}
+
+void ObjMap::doPrint(FILE *out) const {
+    fprintf(out, "{");
+    int index = 0;
+    Value key, value;
+    for (bool first = true; table.next(index, key, value); first = false) {
+        if (!first) fprintf(out, ", ");
+        key.print(out);
+        fprintf(out, ": ");
+        value.print(out);
+    }
+    fprintf(out, "}");
+}
+
+ObjString *ObjSlice::intern(VM &vm) {
+    if (_interned == nullptr) _interned = ObjString::create(vm, chars(), _length);
+    return _interned;
+}
+
+void ObjSlice::doPrint(FILE *out) const {
+    fwrite(chars(), 1, _length, out);
+}
+
+void ObjStringBuilder::append(const char *chars, size_t length) {
+    // doubling keeps appends amortized constant whatever the standard library does
+    if (_text.size() + length > _text.capacity()) {
+        _text.reserve(std::max(2 * _text.capacity(), _text.size() + length));
+    }
+    _text.append(chars, length);
+}
+
+void ObjStringBuilder::append(const Value &value) {
+    if (value.isText()) {
+        std::string_view text = value.asText();
+        append(text.data(), text.size());
+    } else if (value.isNumber()) {
+        char digits[NUMBER_MAX_LENGTH];
+        append(digits, formatNumber(value.asNumber(), digits));
+    } else {
+        // the buffer copies the text out before handing it over, so appending the builder to itself is fine
+        OutputBuffer buffer(64);
+        buffer.setSink([this](const char *data, size_t size) { append(data, size); });
+        buffer.writeValue(value);
+    }
+}
+
+void ObjStringBuilder::doPrint(FILE *out) const {
+    fwrite(_text.data(), 1, _text.size(), out);
+}
+
+ObjFiber::ObjFiber(VM &vm, std::unique_ptr<Fiber> fiber) : Obj(ObjType::Fiber, vm), _fiber(std::move(fiber)) {}
+
+// out of line, Fiber is only complete in vm.h
+ObjFiber::~ObjFiber() = default;
+
+void ObjFiber::doPrint(FILE *out) const {
+    fprintf(out, "<fiber>");
 }
@@ -6,20 +6,34 @@
 #define CPPLOX_OBJECT_H
 
 #include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "chunk.h"
+#include "table.h"
 
 enum class ObjType {
     String,
     Function,
+    Native,
+    List,
+    Map,
+    Slice,
+    StringBuilder,
+    Fiber,
 };
 
 struct Obj {
-    explicit Obj(ObjType type, bool manualAddToVM = false);
+    Obj(ObjType type, VM &vm, bool manualAddToVM = false);
 
-    void addToVM();
+    // owned by something other than a vm, e.g. a StringSpace or CodeObject
+    explicit Obj(ObjType type) : type(type) {}
 
-    void print() const;
+    void addToVM(VM &vm);
+
+    void print(FILE *out) const;
 
     static void free(Obj *obj);
 
@@ -27,15 +41,20 @@ struct Obj {
     Obj *next = nullptr;
 };
 
+// strings made at run time by concatenation are neither hashed nor interned until they're used as a key
 class ObjString : public Obj {
 public:
-    static ObjString *create(const char *chars, int length);
+    static ObjString *create(VM &vm, const char *chars, int length);
+
+    // like create, but a string new to a vm bound to a shared space goes into the space,
+    // for global names that code frozen on the space later has to find
+    static ObjString *createShared(VM &vm, const char *chars, int length);
 
-    static ObjString *concatenate(const ObjString *a, const ObjString *b);
+    static ObjString *concatenate(VM &vm, std::string_view a, std::string_view b);
 
     static void free(ObjString *string);
 
-    void doPrint() const;
+    void doPrint(FILE *out) const;
 
     [[nodiscard]] inline const char *chars() const {
         return reinterpret_cast<const char *>(this) + sizeof(ObjString);
@@ -43,27 +62,191 @@ public:
 
     [[nodiscard]] int length() const { return _length; }
 
-    [[nodiscard]] uint32_t hash() const { return _hash; }
+    [[nodiscard]] inline uint32_t hash() const {
+        if (!_hashed) {
+            _hash = hash(chars(), _length);
+            _hashed = true;
+        }
+        return _hash;
+    }
+
+    [[nodiscard]] inline bool interned() const { return _interned; }
+
+    // the interned string with the same characters, this one unless another got there first
+    ObjString *intern(VM &vm);
 
 private:
+    friend class StringSpace;
+
     static uint32_t hash(const char *key, int length);
 
+    static ObjString *allocate(const char *chars, int length, uint32_t hash);
+
+    // an interned string with these characters, or null
+    static ObjString *find(VM &vm, const char *chars, int length, uint32_t hash);
+
     ObjString(const char *chars, int length, uint32_t hash);
 
-    ObjString(const ObjString *a, const ObjString *b);
+    ObjString(VM &vm, std::string_view a, std::string_view b);
 
     int _length = 0;
-    uint32_t _hash = 0;
+    mutable uint32_t _hash = 0;
+    mutable bool _hashed = false;
+    bool _interned = false;
 };
 
 struct ObjFunction : Obj {
     int arity = 0;
     Chunk chunk;
     ObjString *name = nullptr;
+    JitCode *jitCode = nullptr;
+    // shared between vms through a CodeObject, never quickened or jit compiled lazily
+    bool frozen = false;
+
+    explicit ObjFunction(VM &vm) : Obj(ObjType::Function, vm) {}
 
     ObjFunction() : Obj(ObjType::Function) {}
 
-    void doPrint() const;
+    ~ObjFunction();
+
+    void doPrint(FILE *out) const;
+};
+
+enum class NativeResult {
+    Ok,
+    // already reported through VM::runtimeError
+    Error,
+    // the calling fiber waits until someone delivers the result
+    Block,
+    // ran out of the caller's budget part way, the call runs again once the caller is resumed
+    Suspend,
+};
+
+// args[-1] is the callee's slot and takes the result, data is whatever was registered with the native
+using NativeFn = NativeResult (*)(VM &vm, void *data, int argCount, Value *args);
+
+struct ObjNative : Obj {
+    NativeFn function;
+    void *data;
+    ObjString *name;
+
+    ObjNative(VM &vm, NativeFn function, void *data, ObjString *name)
+            : Obj(ObjType::Native, vm), function(function), data(data), name(name) {}
+
+    void doPrint(FILE *out) const;
+};
+
+// a growable array, stored as raw doubles for as long as it holds nothing but numbers
+class ObjList : public Obj {
+public:
+    explicit ObjList(VM &vm) : Obj(ObjType::List, vm) {}
+
+    [[nodiscard]] inline int count() const {
+        return static_cast<int>(_numeric ? _numbers.size() : _values.size());
+    }
+
+    [[nodiscard]] inline bool numeric() const { return _numeric; }
+
+    // the contiguous storage, only while numeric
+    [[nodiscard]] inline double *numbers() { return _numbers.data(); }
+
+    [[nodiscard]] inline const double *numbers() const { return _numbers.data(); }
+
+    [[nodiscard]] inline Value get(int index) const { return _numeric ? Value(_numbers[index]) : _values[index]; }
+
+    void set(int index, Value value);
+
+    void append(Value value);
+
+    void reserve(int count);
+
+    // true if number is a whole index into the list
+    [[nodiscard]] bool index(double number, int &index) const;
+
+    void doPrint(FILE *out) const;
+
+private:
+    // boxes every element, the list stays generic from then on
+    void spill();
+
+    bool _numeric = true;
+    std::vector<double> _numbers;
+    std::vector<Value> _values;
+};
+
+// a range of a string sharing its characters, interned only once it's needed as a map key
+class ObjSlice : public Obj {
+public:
+    // string is never a slice itself, slices of slices point at the original string
+    ObjSlice(VM &vm, ObjString *string, int start, int length)
+            : Obj(ObjType::Slice, vm), _string(string), _start(start), _length(length) {}
+
+    // not null terminated
+    [[nodiscard]] inline const char *chars() const { return _string->chars() + _start; }
+
+    [[nodiscard]] inline int length() const { return _length; }
+
+    [[nodiscard]] inline ObjString *string() const { return _string; }
+
+    [[nodiscard]] inline int start() const { return _start; }
+
+    // the interned string with the same characters
+    ObjString *intern(VM &vm);
+
+    void doPrint(FILE *out) const;
+
+private:
+    ObjString *_string;
+    int _start;
+    int _length;
+    ObjString *_interned = nullptr;
+};
+
+// mutable text that grows geometrically, nothing is interned until the script asks for a string
+class ObjStringBuilder : public Obj {
+public:
+    explicit ObjStringBuilder(VM &vm) : Obj(ObjType::StringBuilder, vm) {}
+
+    void append(const char *chars, size_t length);
+
+    // text as print would show it
+    void append(const Value &value);
+
+    [[nodiscard]] inline const std::string &text() const { return _text; }
+
+    void doPrint(FILE *out) const;
+
+private:
+    std::string _text;
+};
+
+// a fiber a script spawned, the vm resumes it like any host fiber
+class ObjFiber : public Obj {
+public:
+    ObjFiber(VM &vm, std::unique_ptr<Fiber> fiber);
+
+    ~ObjFiber();
+
+    [[nodiscard]] inline Fiber &fiber() const { return *_fiber; }
+
+    void doPrint(FILE *out) const;
+
+private:
+    std::unique_ptr<Fiber> _fiber;
+};
+
+// a hash map from any value but nil or nan to any value
+struct ObjMap : Obj {
+    Table table;
+
+    explicit ObjMap(VM &vm) : Obj(ObjType::Map, vm) {}
+
+    // nan never equals itself, so it could never be found again
+    [[nodiscard]] static inline bool validKey(const Value &key) {
+        return !key.isNil() && !(key.isNumber() && key.asNumber() != key.asNumber());
+    }
+
+    void doPrint(FILE *out) const;
 };
 
 #endif //CPPLOX_OBJECT_H
@@ -0,0 +1,22 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "op_code.h"
+
+const char *toString(OpCode opCode) {
+    static const char *STRINGS[]{
+            "OP_CONSTANT", "OP_NIL", "OP_TRUE", "OP_FALSE", "OP_POP",
+            "OP_GET_LOCAL", "OP_SET_LOCAL", "OP_GET_GLOBAL", "OP_DEFINE_GLOBAL", "OP_SET_GLOBAL",
+            "OP_EQUAL", "OP_NOT_EQUAL", "OP_GREATER", "OP_GREATER_EQUAL", "OP_LESS", "OP_LESS_EQUAL",
+            "OP_ADD", "OP_SUBTRACT", "OP_MULTIPLY", "OP_DIVIDE", "OP_MODULO", "OP_NOT", "OP_NEGATE",
+            "OP_PRINT", "OP_JUMP", "OP_JUMP_IF_TRUE", "OP_JUMP_IF_FALSE", "OP_POP_JUMP_IF_FALSE",
+            "OP_LOOP", "OP_CALL", "OP_RETURN", "OP_YIELD",
+            "OP_BUILD_LIST", "OP_BUILD_MAP", "OP_GET_INDEX", "OP_SET_INDEX",
+            // quickened forms
+            "OP_ADD_NUMBER", "OP_CONCAT_STRING", "OP_SUBTRACT_NUMBER", "OP_MULTIPLY_NUMBER",
+            "OP_DIVIDE_NUMBER", "OP_MODULO_NUMBER", "OP_GREATER_NUMBER", "OP_GREATER_EQUAL_NUMBER",
+            "OP_LESS_NUMBER", "OP_LESS_EQUAL_NUMBER",
+    };
+    return STRINGS[static_cast<int>(opCode)];
+}
@@ -33,8 +33,32 @@ enum class OpCode {
     Jump,
     JumpIfTrue,
     JumpIfFalse,
+    // pops the condition on both paths, what JumpIfFalse and the Pops after it become
+    PopJumpIfFalse,
     Loop,
+    Call,
     Return,
+    Yield,
+    BuildList,
+    BuildMap,
+    GetIndex,
+    SetIndex,
+    // quickened forms, only ever written into a chunk by the vm
+    AddNumber,
+    ConcatString,
+    SubtractNumber,
+    MultiplyNumber,
+    DivideNumber,
+    ModuloNumber,
+    GreaterNumber,
+    GreaterEqualNumber,
+    LessNumber,
+    LessEqualNumber,
 };
 
+// keep in sync with STRINGS in op_code.cpp
+constexpr int OP_CODE_COUNT = static_cast<int>(OpCode::LessEqualNumber) + 1;
+
+const char *toString(OpCode opCode);
+
 #endif //CPPLOX_OP_CODE_H
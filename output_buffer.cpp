@@ -0,0 +1,93 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "output_buffer.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+#include "number.h"
+#include "object.h"
+
+OutputBuffer::Sink OutputBuffer::fileSink(FILE *file) {
+    return [file](const char *data, size_t size) { fwrite(data, 1, size, file); };
+}
+
+OutputBuffer::Sink OutputBuffer::fdSink(int fd) {
+    return [fd](const char *data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            data += written;
+            size -= written;
+        }
+    };
+}
+
+OutputBuffer::Sink OutputBuffer::stringSink(std::string &target) {
+    return [&target](const char *data, size_t size) { target.append(data, size); };
+}
+
+OutputBuffer::OutputBuffer(size_t threshold) : _threshold(threshold), _sink(fileSink(stdout)) {
+    _buffer.reserve(threshold);
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::setSink(Sink sink) {
+    flush();
+    _sink = std::move(sink);
+}
+
+void OutputBuffer::flush() {
+    if (_buffer.empty()) return;
+    if (_sink) _sink(_buffer.data(), _buffer.size());
+    _buffer.clear();
+}
+
+void OutputBuffer::writeNumber(double number) {
+    char digits[NUMBER_MAX_LENGTH];
+    write(digits, formatNumber(number, digits));
+}
+
+void OutputBuffer::writeValue(const Value &value) {
+    if (value.isNumber()) {
+        writeNumber(value.asNumber());
+    } else if (value.isString()) {
+        const ObjString *string = value.asString();
+        write(string->chars(), string->length());
+    } else if (value.isShortString()) {
+        std::string_view text = value.asText();
+        write(text.data(), text.size());
+    } else if (value.isSlice()) {
+        const ObjSlice *slice = value.asSlice();
+        write(slice->chars(), slice->length());
+    } else if (value.isStringBuilder()) {
+        const std::string &text = value.asStringBuilder()->text();
+        write(text.data(), text.size());
+    } else if (value.isBool()) {
+        if (value.asBool()) {
+            write("true", 4);
+        } else {
+            write("false", 5);
+        }
+    } else if (value.isNil()) {
+        write("nil", 3);
+    } else {
+        // rare enough to go through stdio
+        char *text = nullptr;
+        size_t size = 0;
+        FILE *stream = open_memstream(&text, &size);
+        value.print(stream);
+        fclose(stream);
+        write(text, size);
+        free(text);
+    }
+}
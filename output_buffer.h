@@ -0,0 +1,58 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_OUTPUT_BUFFER_H
+#define CPPLOX_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "non_copyable.h"
+#include "value.h"
+
+// collects what scripts print and hands it to the sink in large blocks
+class OutputBuffer : NonCopyable {
+public:
+    using Sink = std::function<void(const char *data, size_t size)>;
+
+    static Sink fileSink(FILE *file);
+
+    // raw write(2) calls, nothing buffered in stdio on top
+    static Sink fdSink(int fd);
+
+    static Sink stringSink(std::string &target);
+
+    explicit OutputBuffer(size_t threshold = 64 * 1024);
+
+    ~OutputBuffer();
+
+    // flushes what was written to the previous sink first
+    void setSink(Sink sink);
+
+    inline void write(const char *data, size_t size) {
+        _buffer.insert(_buffer.end(), data, data + size);
+        if (_buffer.size() >= _threshold) flush();
+    }
+
+    inline void put(char c) {
+        _buffer.push_back(c);
+        if (_buffer.size() >= _threshold) flush();
+    }
+
+    void writeNumber(double number);
+
+    void writeValue(const Value &value);
+
+    void flush();
+
+private:
+    std::vector<char> _buffer;
+    size_t _threshold;
+    Sink _sink;
+};
+
+#endif //CPPLOX_OUTPUT_BUFFER_H
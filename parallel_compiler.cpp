@@ -0,0 +1,288 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "parallel_compiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compiler.h"
+#include "object.h"
+#include "op_code.h"
+#include "scanner.h"
+#include "thread_pool.h"
+#include "vm.h"
+
+namespace {
+    struct Unit {
+        const char *start;
+        const char *end;
+        int line;
+    };
+
+    struct Piece {
+        std::string source;
+        int line = 1;
+        std::unique_ptr<VM> vm;
+        ObjFunction *function = nullptr;
+        std::string errors;
+    };
+}
+
+// cuts after every ';' or block closing '}' outside of any brackets unless an 'else' follows,
+// a '{' only opens a block where a statement can start, anywhere else it's a map literal,
+// returns nothing if the brackets don't balance so the real compiler reports it
+static std::vector<Unit> splitDeclarations(const char *source) {
+    std::vector<Unit> units;
+    Scanner scanner;
+    scanner.init(source);
+
+    const char *unitStart = source;
+    int unitLine = 1;
+    const char *pendingEnd = nullptr;
+    int pendingLine = 0;
+    int depth = 0;
+    TokenType previous = TokenType::Semicolon;
+    bool block = false;
+
+    while (true) {
+        Token token = scanner.scan();
+        if (token.type == TokenType::Error) return {};
+
+        if (pendingEnd != nullptr && token.type != TokenType::Else) {
+            units.push_back({unitStart, pendingEnd, unitLine});
+            unitStart = pendingEnd;
+            unitLine = pendingLine;
+        }
+        pendingEnd = nullptr;
+
+        switch (token.type) {
+            case TokenType::LeftBrace:
+                if (depth == 0) {
+                    block = previous == TokenType::Semicolon || previous == TokenType::RightBrace ||
+                            previous == TokenType::RightParen || previous == TokenType::Else;
+                }
+                depth++;
+                break;
+            case TokenType::LeftParen:
+            case TokenType::LeftBracket:
+                depth++;
+                break;
+            case TokenType::RightParen:
+            case TokenType::RightBrace:
+            case TokenType::RightBracket:
+                if (--depth < 0) return {};
+                break;
+            default:
+                break;
+        }
+        previous = token.type;
+
+        if (token.type == TokenType::Eof) {
+            if (depth != 0) return {};
+            if (token.start != unitStart) units.push_back({unitStart, token.start, unitLine});
+            return units;
+        }
+
+        if (depth == 0 && (token.type == TokenType::Semicolon || (token.type == TokenType::RightBrace && block))) {
+            pendingEnd = token.start + token.length;
+            pendingLine = token.line;
+        }
+    }
+}
+
+static void compilePiece(Piece &piece) {
+    char *output = nullptr;
+    size_t outputSize = 0;
+    char *errors = nullptr;
+    size_t errorsSize = 0;
+    FILE *out = open_memstream(&output, &outputSize);
+    FILE *err = open_memstream(&errors, &errorsSize);
+
+    piece.vm = std::make_unique<VM>();
+    piece.vm->setOutput(out, err);
+    Compiler compiler(*piece.vm);
+    piece.function = compiler.compile(piece.source.c_str(), piece.line);
+
+    // compiled with DEBUG_PRINT_CODE the pieces disassemble themselves, only the linked script is worth showing
+    fclose(out);
+    fclose(err);
+    piece.errors.assign(errors, errorsSize);
+    free(output);
+    free(errors);
+}
+
+// constants are merged, equal numbers and strings share one slot, every function gets its own
+class Linker {
+public:
+    explicit Linker(VM &vm) : _vm(vm), _function(new ObjFunction(vm)) {}
+
+    bool add(const ObjFunction *function) {
+        const Chunk &from = function->chunk;
+        std::vector<uint8_t> constants(from.constantCount());
+        for (int i = 0; i < from.constantCount(); i++) {
+            int index = constant(from.constants()[i]);
+            if (index > UINT8_MAX) {
+                fprintf(_vm.errorStream(), "[line %d] Error: Too many constants in one chunk.\n",
+                        from.count() > 0 ? from.getInstructionLine(0) : 0);
+                return false;
+            }
+            constants[i] = static_cast<uint8_t>(index);
+        }
+
+        // every piece ends with its own nil return
+        int count = from.count() - 2;
+        Chunk &chunk = _function->chunk;
+        int offset = 0;
+        while (offset < count) {
+            auto opCode = static_cast<OpCode>(from.code()[offset]);
+            int size = Chunk::instructionSize(opCode);
+            chunk.write(from.code()[offset], from.getInstructionLine(offset));
+            for (int i = 1; i < size; i++) {
+                chunk.write(from.code()[offset + i], from.getInstructionLine(offset + i));
+            }
+            if (hasConstantOperand(opCode)) {
+                chunk.patch(chunk.count() - 1, constants[from.code()[offset + 1]]);
+            }
+            offset += size;
+        }
+        _lastLine = from.getInstructionLine(count);
+        return true;
+    }
+
+    ObjFunction *finish() {
+        _function->chunk.write(static_cast<uint8_t>(OpCode::Nil), _lastLine);
+        _function->chunk.write(static_cast<uint8_t>(OpCode::Return), _lastLine);
+        return _function;
+    }
+
+private:
+    static bool hasConstantOperand(OpCode opCode) {
+        switch (opCode) {
+            case OpCode::Constant:
+            case OpCode::GetGlobal:
+            case OpCode::DefineGlobal:
+            case OpCode::SetGlobal:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // the pieces' vms go away with them, functions are rebuilt in the target vm
+    ObjFunction *copy(const ObjFunction *function) { // NOLINT(misc-no-recursion)
+        auto copied = new ObjFunction(_vm);
+        copied->arity = function->arity;
+        if (function->name != nullptr) {
+            copied->name = ObjString::create(_vm, function->name->chars(), function->name->length());
+        }
+
+        const Chunk &from = function->chunk;
+        for (int i = 0; i < from.constantCount(); i++) {
+            Value value = from.constants()[i];
+            if (value.isString()) {
+                const ObjString *string = value.asString();
+                value = Value(ObjString::create(_vm, string->chars(), string->length()));
+            } else if (value.isFunction()) {
+                value = Value(copy(value.asFunction()));
+            }
+            copied->chunk.addConstant(value);
+        }
+        for (int i = 0; i < from.count(); i++) {
+            copied->chunk.write(from.code()[i], from.getInstructionLine(i));
+        }
+        return copied;
+    }
+
+    int constant(Value value) {
+        if (value.isFunction()) {
+            return _function->chunk.addConstant(Value(copy(value.asFunction())));
+        }
+
+        if (value.isString()) {
+            const ObjString *string = value.asString();
+            ObjString *interned = ObjString::create(_vm, string->chars(), string->length());
+            return slot<const ObjString *>(_strings, interned, Value(interned));
+        }
+
+        if (value.isShortString()) {
+            return slot<std::string>(_shortStrings, std::string(value.asText()), value);
+        }
+
+        double number = value.asNumber();
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        return slot<uint64_t>(_numbers, bits, value);
+    }
+
+    template<typename Key>
+    int slot(std::unordered_map<Key, int> &slots, Key key, Value value) {
+        auto it = slots.find(key);
+        if (it != slots.end()) return it->second;
+
+        int index = _function->chunk.addConstant(value);
+        slots.emplace(key, index);
+        return index;
+    }
+
+    VM &_vm;
+    ObjFunction *_function;
+    std::unordered_map<const ObjString *, int> _strings;
+    std::unordered_map<std::string, int> _shortStrings;
+    std::unordered_map<uint64_t, int> _numbers;
+    int _lastLine = 1;
+};
+
+ObjFunction *compileParallel(VM &vm, const char *source, int jobs) {
+    std::vector<Unit> units = splitDeclarations(source);
+
+    // a few pieces per thread so one slow piece doesn't hold the rest up
+    size_t length = strlen(source);
+    size_t pieceLength = length / (jobs * 4) + 1;
+    std::vector<Piece> pieces;
+    for (const Unit &unit: units) {
+        if (pieces.empty() || pieces.back().source.size() >= pieceLength) {
+            pieces.emplace_back();
+            pieces.back().line = unit.line;
+        }
+        pieces.back().source.append(unit.start, unit.end);
+    }
+
+    if (jobs < 2 || pieces.size() < 2) {
+        Compiler compiler(vm);
+        return compiler.compile(source);
+    }
+
+    {
+        ThreadPool pool(jobs);
+        for (Piece &piece: pieces) {
+            pool.submit([&piece] { compilePiece(piece); });
+        }
+        pool.wait();
+    }
+
+    bool hadError = false;
+    for (const Piece &piece: pieces) {
+        fwrite(piece.errors.data(), 1, piece.errors.size(), vm.errorStream());
+        hadError = hadError || piece.function == nullptr;
+    }
+    if (hadError) return nullptr;
+
+    Linker linker(vm);
+    for (const Piece &piece: pieces) {
+        if (!linker.add(piece.function)) return nullptr;
+    }
+    ObjFunction *function = linker.finish();
+
+#ifdef DEBUG_PRINT_CODE
+    function->chunk.disassemble("<script>", vm.outputStream());
+#endif
+
+    return function;
+}
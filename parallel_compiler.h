@@ -0,0 +1,15 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_PARALLEL_COMPILER_H
+#define CPPLOX_PARALLEL_COMPILER_H
+
+#include "forward.h"
+
+// splits source between top-level declarations, compiles the pieces on jobs threads
+// each in a scratch vm, then links them into one script owned by vm,
+// falls back to a plain compile when the source can't be split
+ObjFunction *compileParallel(VM &vm, const char *source, int jobs);
+
+#endif //CPPLOX_PARALLEL_COMPILER_H
@@ -4,8 +4,6 @@
 
 #include "parser.h"
 
-#include <cstdio>
-
 void Parser::advance() {
     _previous = _current;
     while (true) {
@@ -44,6 +42,7 @@ void Parser::synchronize() {
             case TokenType::While:
             case TokenType::Print:
             case TokenType::Return:
+            case TokenType::Yield:
                 return;
             default:
                 break;
@@ -56,16 +55,16 @@ void Parser::errorAt(const Token &token, const char *message) {
     if (_panicMode) return;
     _panicMode = true;
 
-    fprintf(stderr, "[line %d] Error", token.line);
+    fprintf(_err, "[line %d] Error", token.line);
 
     if (token.type == TokenType::Eof) {
-        fprintf(stderr, " at endScope");
+        fprintf(_err, " at endScope");
     } else if (token.type == TokenType::Error) {
         // nothing
     } else {
-        fprintf(stderr, " at '%.*s'", token.length, token.start);
+        fprintf(_err, " at '%.*s'", token.length, token.start);
     }
 
-    fprintf(stderr, ": %s\n", message);
+    fprintf(_err, ": %s\n", message);
     _hadError = true;
 }
@@ -5,15 +5,21 @@
 #ifndef CPPLOX_PARSER_H
 #define CPPLOX_PARSER_H
 
-#include <cstdlib>
+#include <cstdio>
 
+#include "number.h"
 #include "scanner.h"
 #include "value.h"
 
 // actually just a token iterator
 class Parser {
 public:
-    inline void init(const char *source) { _scanner.init(source); }
+    inline void init(const char *source, FILE *err, int line = 1) {
+        _scanner.init(source, line);
+        _err = err;
+        _hadError = false;
+        _panicMode = false;
+    }
 
     [[nodiscard]] inline bool hadError() const { return _hadError; }
 
@@ -29,9 +35,14 @@ public:
 
     void synchronize();
 
-    [[nodiscard]] inline Value number() const { return Value(strtod(_previous.start, nullptr)); }
+    // the scanner only produces valid literals
+    [[nodiscard]] inline Value number() const {
+        double number = 0;
+        parseNumber(_previous.start, _previous.length, number);
+        return Value(number);
+    }
 
-    [[nodiscard]] inline Value string() const { return {_previous.start + 1, _previous.length - 2}; }
+    [[nodiscard]] inline Value string(VM &vm) const { return {vm, _previous.start + 1, _previous.length - 2}; }
 
     [[nodiscard]] inline const Token &previous() const { return _previous; }
 
@@ -47,6 +58,7 @@ private:
     Token _previous;
     bool _hadError = false;
     bool _panicMode = false;
+    FILE *_err = stderr;
 };
 
 #endif //CPPLOX_PARSER_H
@@ -0,0 +1,114 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <x86intrin.h>
+
+#endif
+
+uint64_t Profiler::now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Profiler::beginSample(OpCode opCode, int line) {
+    _countdown = SAMPLE_PERIOD;
+    _pending = true;
+    _pendingOpCode = opCode;
+    _pendingLine = line;
+    _sampleStart = now();
+}
+
+void Profiler::endSample() {
+    // scale the sample up so totals estimate the whole run
+    uint64_t cycles = (now() - _sampleStart) * SAMPLE_PERIOD;
+    _pending = false;
+
+    _opCodes[static_cast<int>(_pendingOpCode)].cycles += cycles;
+    _lines[_pendingLine].cycles += cycles;
+    if (_pendingLine >= static_cast<int>(_lineOpCycles.size())) _lineOpCycles.resize(_pendingLine + 1);
+    _lineOpCycles[_pendingLine][static_cast<int>(_pendingOpCode)] += cycles;
+}
+
+void Profiler::finish() {
+    if (_pending) endSample();
+}
+
+uint64_t Profiler::instructionCount() const {
+    uint64_t count = 0;
+    for (const Counter &counter: _opCodes) {
+        count += counter.count;
+    }
+    return count;
+}
+
+static double percent(uint64_t part, uint64_t total) {
+    return total == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(total);
+}
+
+void Profiler::report(FILE *out) const {
+    uint64_t totalCount = 0;
+    uint64_t totalCycles = 0;
+    for (const Counter &counter: _opCodes) {
+        totalCount += counter.count;
+        totalCycles += counter.cycles;
+    }
+
+    fprintf(out, "== profile: %llu instructions, ~%llu cycles ==\n",
+            static_cast<unsigned long long>(totalCount), static_cast<unsigned long long>(totalCycles));
+
+    std::vector<int> order;
+    for (int i = 0; i < OP_CODE_COUNT; i++) {
+        if (_opCodes[i].count > 0) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return _opCodes[a].cycles > _opCodes[b].cycles; });
+
+    fprintf(out, "%-24s %14s %7s %16s %7s\n", "op code", "count", "%", "cycles", "%");
+    for (int i: order) {
+        const Counter &counter = _opCodes[i];
+        fprintf(out, "%-24s %14llu %6.2f%% %16llu %6.2f%%\n", toString(static_cast<OpCode>(i)),
+                static_cast<unsigned long long>(counter.count), percent(counter.count, totalCount),
+                static_cast<unsigned long long>(counter.cycles), percent(counter.cycles, totalCycles));
+    }
+
+    order.clear();
+    for (int i = 0; i < static_cast<int>(_lines.size()); i++) {
+        if (_lines[i].count > 0) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return _lines[a].cycles > _lines[b].cycles; });
+
+    fprintf(out, "%-24s %14s %7s %16s %7s\n", "line", "count", "%", "cycles", "%");
+    for (int i: order) {
+        const Counter &counter = _lines[i];
+        fprintf(out, "%-24d %14llu %6.2f%% %16llu %6.2f%%\n", i,
+                static_cast<unsigned long long>(counter.count), percent(counter.count, totalCount),
+                static_cast<unsigned long long>(counter.cycles), percent(counter.cycles, totalCycles));
+    }
+}
+
+bool Profiler::writeFolded(const char *path) const {
+    FILE *file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    for (int line = 0; line < static_cast<int>(_lineOpCycles.size()); line++) {
+        for (int i = 0; i < OP_CODE_COUNT; i++) {
+            uint64_t cycles = _lineOpCycles[line][i];
+            if (cycles == 0) continue;
+            fprintf(file, "script;line %d;%s %llu\n", line, toString(static_cast<OpCode>(i)),
+                    static_cast<unsigned long long>(cycles));
+        }
+    }
+
+    return fclose(file) == 0;
+}
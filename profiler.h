@@ -0,0 +1,64 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_PROFILER_H
+#define CPPLOX_PROFILER_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "non_copyable.h"
+#include "op_code.h"
+
+// counts every dispatched instruction, times one in SAMPLE_PERIOD of them
+class Profiler : NonCopyable {
+public:
+    static constexpr int SAMPLE_PERIOD = 64;
+
+    inline void instruction(OpCode opCode, int line) {
+        if (_pending) endSample();
+
+        _opCodes[static_cast<int>(opCode)].count++;
+        if (line >= static_cast<int>(_lines.size())) _lines.resize(line + 1);
+        _lines[line].count++;
+
+        if (--_countdown == 0) beginSample(opCode, line);
+    }
+
+    // closes the sample still in flight when the script returns or fails
+    void finish();
+
+    [[nodiscard]] uint64_t instructionCount() const;
+
+    void report(FILE *out) const;
+
+    // one "script;line N;OP_NAME cycles" row per line and op code, for flamegraph.pl and friends
+    bool writeFolded(const char *path) const;
+
+private:
+    struct Counter {
+        uint64_t count = 0;
+        uint64_t cycles = 0;
+    };
+
+    static uint64_t now();
+
+    void beginSample(OpCode opCode, int line);
+
+    void endSample();
+
+    std::array<Counter, OP_CODE_COUNT> _opCodes{};
+    std::vector<Counter> _lines;
+    std::vector<std::array<uint64_t, OP_CODE_COUNT>> _lineOpCycles;
+
+    int _countdown = SAMPLE_PERIOD;
+    bool _pending = false;
+    OpCode _pendingOpCode{};
+    int _pendingLine = 0;
+    uint64_t _sampleStart = 0;
+};
+
+#endif //CPPLOX_PROFILER_H
@@ -0,0 +1,14 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "repl.h"
+
+VM::InterpretResult Repl::interpret(const char *line) {
+    // the previous line is done with, functions it declared are objects of their own
+    _context.reset();
+    ObjFunction *script = _compiler.compile(line, _context);
+    if (script == nullptr) return VM::InterpretResult::CompileError;
+
+    return _vm.interpret(script);
+}
@@ -0,0 +1,27 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_REPL_H
+#define CPPLOX_REPL_H
+
+#include "compiler.h"
+#include "compiler_context.h"
+#include "non_copyable.h"
+#include "vm.h"
+
+// an interactive session on one vm, every line is compiled into the same script function
+// so a session of any length runs in the same memory, only globals and new strings stay behind
+class Repl : NonCopyable {
+public:
+    explicit Repl(VM &vm) : _vm(vm), _compiler(vm), _context(vm, FunctionType::Script) {}
+
+    VM::InterpretResult interpret(const char *line);
+
+private:
+    VM &_vm;
+    Compiler _compiler;
+    CompilerContext _context;
+};
+
+#endif //CPPLOX_REPL_H
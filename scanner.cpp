@@ -24,12 +24,18 @@ Token Scanner::scan() {
             return makeToken(TokenType::LeftParen);
         case ')':
             return makeToken(TokenType::RightParen);
+        case '[':
+            return makeToken(TokenType::LeftBracket);
+        case ']':
+            return makeToken(TokenType::RightBracket);
         case '{':
             return makeToken(TokenType::LeftBrace);
         case '}':
             return makeToken(TokenType::RightBrace);
         case ';':
             return makeToken(TokenType::Semicolon);
+        case ':':
+            return makeToken(TokenType::Colon);
         case ',':
             return makeToken(TokenType::Comma);
         case '.':
@@ -168,6 +174,8 @@ TokenType Scanner::identifierType() {
             return checkKeyword(1, 2, "ar", TokenType::Var);
         case 'w':
             return checkKeyword(1, 4, "hile", TokenType::While);
+        case 'y':
+            return checkKeyword(1, 4, "ield", TokenType::Yield);
         default:
             break;
     }
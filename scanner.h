@@ -9,10 +9,11 @@
 
 class Scanner {
 public:
-    inline void init(const char *source) {
+    // line is where source starts when it's a piece of a bigger file
+    inline void init(const char *source, int line = 1) {
         _start = source;
         _current = source;
-        _line = 1;
+        _line = line;
     }
 
     Token scan();
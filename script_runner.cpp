@@ -0,0 +1,84 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "script_runner.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+#include "thread_pool.h"
+
+static ScriptResult capture(const std::function<VM::InterpretResult(FILE *out, FILE *err)> &run) {
+    ScriptResult result;
+
+    char *output = nullptr;
+    size_t outputSize = 0;
+    char *errors = nullptr;
+    size_t errorsSize = 0;
+    FILE *out = open_memstream(&output, &outputSize);
+    FILE *err = open_memstream(&errors, &errorsSize);
+
+    result.result = run(out, err);
+
+    fclose(out);
+    fclose(err);
+    result.output.assign(output, outputSize);
+    result.errors.assign(errors, errorsSize);
+    free(output);
+    free(errors);
+
+    return result;
+}
+
+ScriptResult runScript(const std::string &source, bool jit) {
+    return capture([&](FILE *out, FILE *err) {
+        VM vm;
+        vm.setJitEnabled(jit);
+        vm.setOutput(out, err);
+        return vm.interpret(source.c_str());
+    });
+}
+
+ScriptResult runCode(const std::shared_ptr<const CodeObject> &code) {
+    return capture([&](FILE *out, FILE *err) {
+        VM vm(code->strings());
+        vm.setOutput(out, err);
+        return vm.interpret(code);
+    });
+}
+
+std::vector<ScriptResult> runScripts(const std::vector<std::string> &sources, int jobs, bool jit,
+                                     const ScriptCallback &onResult) {
+    std::vector<ScriptResult> results(sources.size());
+    std::vector<bool> done(sources.size(), false);
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    ThreadPool pool(jobs);
+    for (size_t i = 0; i < sources.size(); i++) {
+        pool.submit([&, i] {
+            ScriptResult result = runScript(sources[i], jit);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[i] = std::move(result);
+            done[i] = true;
+            finished.notify_one();
+        });
+    }
+
+    // hand results out in order while later scripts are still running
+    if (onResult) {
+        for (size_t i = 0; i < sources.size(); i++) {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return done[i]; });
+            lock.unlock();
+            onResult(i, results[i]);
+        }
+    }
+
+    pool.wait();
+    return results;
+}
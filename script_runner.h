@@ -0,0 +1,35 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_SCRIPT_RUNNER_H
+#define CPPLOX_SCRIPT_RUNNER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vm.h"
+
+struct ScriptResult {
+    VM::InterpretResult result = VM::InterpretResult::Ok;
+    std::string output;
+    std::string errors;
+};
+
+// runs source in a fresh vm with its output and errors captured
+ScriptResult runScript(const std::string &source, bool jit = false);
+
+// runs frozen code in a fresh vm bound to its string space, jit code comes with the code object
+ScriptResult runCode(const std::shared_ptr<const CodeObject> &code);
+
+using ScriptCallback = std::function<void(size_t index, const ScriptResult &result)>;
+
+// runs every source in its own vm on a work-stealing pool of jobs threads,
+// onResult is called on the calling thread in source order as soon as each result is available
+std::vector<ScriptResult> runScripts(const std::vector<std::string> &sources, int jobs, bool jit = false,
+                                     const ScriptCallback &onResult = nullptr);
+
+#endif //CPPLOX_SCRIPT_RUNNER_H
@@ -0,0 +1,73 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "string_space.h"
+
+#include <cstring>
+
+#include "object.h"
+
+StringSpace::StringSpace(int buckets) {
+    uint32_t capacity = 1;
+    while (capacity < static_cast<uint32_t>(buckets)) capacity *= 2;
+
+    _buckets = std::make_unique<std::atomic<Node *>[]>(capacity);
+    for (uint32_t i = 0; i < capacity; i++) {
+        _buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+    _mask = capacity - 1;
+}
+
+StringSpace::~StringSpace() {
+    for (uint32_t i = 0; i <= _mask; i++) {
+        Node *node = _buckets[i].load(std::memory_order_relaxed);
+        while (node != nullptr) {
+            Node *next = node->next;
+            ObjString::free(node->string);
+            delete node;
+            node = next;
+        }
+    }
+}
+
+ObjString *StringSpace::find(const Node *head, const Node *stop, const char *chars, int length, uint32_t hash) {
+    for (const Node *node = head; node != stop; node = node->next) {
+        const ObjString *string = node->string;
+        if (string->hash() == hash && string->length() == length && memcmp(string->chars(), chars, length) == 0) {
+            return node->string;
+        }
+    }
+    return nullptr;
+}
+
+ObjString *StringSpace::intern(const char *chars, int length) {
+    return intern(chars, length, ObjString::hash(chars, length));
+}
+
+ObjString *StringSpace::intern(const char *chars, int length, uint32_t hash) {
+    std::atomic<Node *> &head = bucket(hash);
+
+    Node *seen = head.load(std::memory_order_acquire);
+    ObjString *interned = find(seen, nullptr, chars, length, hash);
+    if (interned != nullptr) return interned;
+
+    auto node = new Node{ObjString::allocate(chars, length, hash), seen};
+    // on failure node->next is reloaded with the new head, only the nodes pushed since need checking
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_acquire)) {
+        interned = find(node->next, seen, chars, length, hash);
+        if (interned != nullptr) {
+            ObjString::free(node->string);
+            delete node;
+            return interned;
+        }
+        seen = node->next;
+    }
+
+    _count.fetch_add(1, std::memory_order_relaxed);
+    return node->string;
+}
+
+ObjString *StringSpace::find(const char *chars, int length, uint32_t hash) const {
+    return find(bucket(hash).load(std::memory_order_acquire), nullptr, chars, length, hash);
+}
@@ -0,0 +1,50 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_STRING_SPACE_H
+#define CPPLOX_STRING_SPACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "forward.h"
+#include "non_copyable.h"
+
+// interned strings owned by no vm, shared by every vm bound to the space
+// lookups never lock, inserts race with a single compare and swap on one bucket,
+// strings live as long as the space so readers never see one freed
+class StringSpace : NonCopyable {
+public:
+    // the bucket count is fixed, chains just get longer past it
+    explicit StringSpace(int buckets = 4096);
+
+    ~StringSpace();
+
+    // safe to call from any number of threads
+    ObjString *intern(const char *chars, int length);
+
+    ObjString *intern(const char *chars, int length, uint32_t hash);
+
+    [[nodiscard]] ObjString *find(const char *chars, int length, uint32_t hash) const;
+
+    [[nodiscard]] inline int count() const { return _count.load(std::memory_order_relaxed); }
+
+private:
+    struct Node {
+        ObjString *string;
+        Node *next;
+    };
+
+    // searches the chain from head down to, but not including, stop
+    static ObjString *find(const Node *head, const Node *stop, const char *chars, int length, uint32_t hash);
+
+    [[nodiscard]] inline std::atomic<Node *> &bucket(uint32_t hash) const { return _buckets[hash & _mask]; }
+
+    std::unique_ptr<std::atomic<Node *>[]> _buckets;
+    uint32_t _mask = 0;
+    std::atomic<int> _count{0};
+};
+
+#endif //CPPLOX_STRING_SPACE_H
@@ -9,22 +9,61 @@
 
 #include "object.h"
 
+// murmur3's finalizer, doubles and addresses keep their entropy in the high bits
+// while the capacity is a power of two that only looks at the low ones
+static inline uint32_t mix(uint64_t bits) {
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    bits *= 0xc4ceb9fe1a85ec53ULL;
+    bits ^= bits >> 33;
+    return static_cast<uint32_t>(bits);
+}
+
+static inline uint32_t hashKey(const Value &key) {
+    if (key.isObj()) {
+        const Obj *obj = key.asObj();
+        if (obj->type == ObjType::String) return static_cast<const ObjString *>(obj)->hash();
+        return mix(reinterpret_cast<uintptr_t>(obj));
+    }
+    if (key.isShortString()) {
+        std::string_view text = key.asText();
+        uint64_t words[2]{};
+        memcpy(words, text.data(), text.size());
+        return mix(words[0] ^ mix(words[1] ^ text.size()) * 0x9e3779b97f4a7c15ULL);
+    }
+    if (key.isNumber()) {
+        // -0 and 0 are the same key
+        double number = key.asNumber() == 0 ? 0 : key.asNumber();
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        return mix(bits);
+    }
+    return key.asBool() ? 1231 : 1237;
+}
+
+// strings are interned, so every object key compares by identity, short strings compare as values
+static inline bool keysEqual(const Value &a, const Value &b) {
+    if (a.isObj()) return b.isObj() && a.asObj() == b.asObj();
+    return a == b;
+}
+
 Table::~Table() {
     delete[] _entries;
 }
 
-Table::Entry *Table::find(Entry *entries, int capacity, const ObjString *key) {
-    uint32_t index = key->hash() % capacity;
+Table::Entry *Table::find(Entry *entries, int capacity, const Value &key) {
+    uint32_t index = hashKey(key) % capacity;
     Entry *tombstone = nullptr;
     while (true) {
         Entry *entry = entries + index;
-        if (entry->key == nullptr) {
+        if (entry->key.isNil()) {
             if (entry->value.isNil()) {
                 return tombstone != nullptr ? tombstone : entry;
             } else {
                 if (tombstone == nullptr) tombstone = entry;
             }
-        } else if (entry->key == key) {
+        } else if (keysEqual(entry->key, key)) {
             return entry;
         }
         index = (index + 1) % capacity;
@@ -37,7 +76,7 @@ void Table::resize(int capacity) {
     _count = 0;
     for (int i = 0; i < _capacity; i++) {
         Entry *entry = _entries + i;
-        if (entry->key == nullptr) continue;
+        if (entry->key.isNil()) continue;
 
         Entry *dest = find(entries, capacity, entry->key);
         dest->key = entry->key;
@@ -50,64 +89,97 @@ void Table::resize(int capacity) {
     _capacity = capacity;
 }
 
-bool Table::get(const ObjString *key, Value *value) {
+bool Table::get(const Value &key, Value *value) const {
     if (_count == 0) return false;
 
     Entry *entry = find(key);
-    if (entry->key == nullptr) return false;
+    if (entry->key.isNil()) return false;
 
     *value = entry->value;
     return true;
 }
 
-bool Table::set(ObjString *key, Value value) {
+bool Table::set(const Value &key, Value value) {
     if (_count + 1 > static_cast<int>(static_cast<double>(_capacity) * 0.75)) {
         int capacity = _capacity < 8 ? 8 : 2 * _capacity;
         resize(capacity);
     }
 
     Entry *entry = find(key);
-    bool isNewKey = entry->key == nullptr;
+    bool isNewKey = entry->key.isNil();
     if (isNewKey && entry->value.isNil()) _count++;
+    if (isNewKey) _size++;
 
     entry->key = key;
     entry->value = value;
     return isNewKey;
 }
 
-bool Table::remove(const ObjString *key) {
+bool Table::remove(const Value &key) {
     if (_count == 0) return false;
 
     Entry *entry = find(key);
-    if (entry->key == nullptr) return false;
+    if (entry->key.isNil()) return false;
 
-    entry->key = nullptr;
+    entry->key = Value();
     entry->value = Value(true);
+    _size--;
     return true;
 }
 
-void Table::merge(Table &from) {
+void Table::merge(const Table &from) {
+    reserve(_size + from._size);
     for (int i = 0; i < from._capacity; i++) {
         Entry *entry = from._entries + i;
-        if (entry->key != nullptr) {
+        if (!entry->key.isNil()) {
             set(entry->key, entry->value);
         }
     }
 }
 
-ObjString *Table::find(const char *chars, int length, uint32_t hash) {
+void Table::reserve(int count) {
+    int capacity = _capacity < 8 ? 8 : _capacity;
+    while (count > static_cast<int>(static_cast<double>(capacity) * 0.75)) {
+        capacity *= 2;
+    }
+    if (capacity != _capacity) resize(capacity);
+}
+
+void Table::setAll(const Value *pairs, int count) {
+    reserve(_count + count);
+    for (int i = 0; i < count; i++) {
+        set(pairs[2 * i], pairs[2 * i + 1]);
+    }
+}
+
+ObjString *Table::find(const char *chars, int length, uint32_t hash) const {
     if (_count == 0) return nullptr;
     uint32_t index = hash % _capacity;
     while (true) {
         Entry *entry = _entries + index;
-        ObjString *key = entry->key;
-        if (key == nullptr) {
+        if (entry->key.isNil()) {
             if (entry->value.isNil()) return nullptr;
-        } else if (key->length() == length &&
-                   key->hash() == hash &&
-                   memcmp(key->chars(), chars, length) == 0) {
-            return key;
+        } else {
+            ObjString *key = entry->key.asString();
+            if (key->length() == length &&
+                key->hash() == hash &&
+                memcmp(key->chars(), chars, length) == 0) {
+                return key;
+            }
         }
         index = (index + 1) % _capacity;
     }
 }
+
+bool Table::next(int &index, Value &key, Value &value) const {
+    for (; index < _capacity; index++) {
+        const Entry &entry = _entries[index];
+        if (entry.key.isNil()) continue;
+
+        key = entry.key;
+        value = entry.value;
+        index++;
+        return true;
+    }
+    return false;
+}
@@ -9,33 +9,48 @@
 
 #include "value.h"
 
+// open addressing hash table, keys are any value but nil, objects are keyed by identity
 class Table {
 public:
     ~Table();
 
-    bool get(const ObjString *key, Value *value);
+    bool get(const Value &key, Value *value) const;
 
-    bool set(ObjString *key, Value value);
+    bool set(const Value &key, Value value);
 
-    bool remove(const ObjString *key);
+    bool remove(const Value &key);
 
-    void merge(Table &from);
+    void merge(const Table &from);
 
-    ObjString *find(const char *chars, int length, uint32_t hash);
+    // makes room for count entries so inserting that many never resizes
+    void reserve(int count);
+
+    // pairs alternates count keys and their values
+    void setAll(const Value *pairs, int count);
+
+    ObjString *find(const char *chars, int length, uint32_t hash) const;
+
+    [[nodiscard]] inline int size() const { return _size; }
+
+    // steps index to the next live entry, false once there are no more
+    bool next(int &index, Value &key, Value &value) const;
 
 private:
     struct Entry {
-        ObjString *key = nullptr;
+        // nil marks an empty entry, or a tombstone if value is true
+        Value key;
         Value value;
     };
 
-    static Entry *find(Entry *entries, int capacity, const ObjString *key);
+    static Entry *find(Entry *entries, int capacity, const Value &key);
 
-    inline Entry *find(const ObjString *key) { return find(_entries, _capacity, key); }
+    inline Entry *find(const Value &key) const { return find(_entries, _capacity, key); }
 
     void resize(int capacity);
 
+    // live entries plus tombstones
     int _count = 0;
+    int _size = 0;
     int _capacity = 0;
     Entry *_entries = nullptr;
 };
@@ -0,0 +1,83 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "code_object.h"
+#include "string_space.h"
+#include "vm.h"
+
+struct HostTest {
+    const char *name;
+    std::function<bool()> run;
+};
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return false; \
+        } \
+    } while (false)
+
+// a budget bounds the script whether the backward jumps are its own or those of a fiber it resumes
+static bool nestedFiberSpendsBudget() {
+    VM vm;
+    ObjFunction *function = vm.compile(
+            "fun spin() { var i = 0; while (i < 100000) { i = i + 1; } return i; }\n"
+            "var result = resume(fiber(spin));\n");
+    CHECK(function != nullptr);
+
+    int slices = 1;
+    VM::InterpretResult result = vm.interpret(function, 1000);
+    while (result == VM::InterpretResult::Suspended) {
+        slices++;
+        result = vm.run(1000);
+    }
+    CHECK(result == VM::InterpretResult::Ok);
+    CHECK(slices >= 100);
+
+    Value value;
+    CHECK(vm.getGlobal("result", value));
+    CHECK(value.isNumber() && value.asNumber() == 100000);
+    return true;
+}
+
+// globals the vm defined before the code was frozen are keyed by the strings the code uses
+static bool codeFrozenAfterVmFindsGlobals() {
+    auto space = std::make_shared<StringSpace>();
+    VM vm(space);
+    vm.setGlobal("limit", Value(3.0));
+
+    VM builder;
+    ObjFunction *function = builder.compile("var result = len([1, 2, 3]) + limit;\n");
+    CHECK(function != nullptr);
+    std::shared_ptr<const CodeObject> code = CodeObject::freeze(function, space);
+    CHECK(code != nullptr);
+    CHECK(vm.interpret(code) == VM::InterpretResult::Ok);
+
+    Value value;
+    CHECK(vm.getGlobal("result", value));
+    CHECK(value.isNumber() && value.asNumber() == 6);
+    return true;
+}
+
+int main() {
+    const std::vector<HostTest> tests{
+            {"nested fiber spends budget", nestedFiberSpendsBudget},
+            {"code frozen after vm finds globals", codeFrozenAfterVmFindsGlobals},
+    };
+
+    int failed = 0;
+    for (const HostTest &test: tests) {
+        bool passed = test.run();
+        printf("%s %s\n", passed ? "ok  " : "FAIL", test.name);
+        if (!passed) failed++;
+    }
+    return failed == 0 ? 0 : 1;
+}
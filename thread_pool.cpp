@@ -0,0 +1,102 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#include "thread_pool.h"
+
+static thread_local int currentWorker = -1;
+static thread_local const ThreadPool *currentPool = nullptr;
+
+ThreadPool::ThreadPool(int workers) {
+    if (workers < 1) workers = 1;
+    for (int i = 0; i < workers; i++) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < workers; i++) {
+        _threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (std::thread &thread: _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    int index;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _unfinished++;
+        index = currentPool == this ? currentWorker : _nextWorker++ % workerCount();
+    }
+
+    Worker &worker = *_workers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    {
+        // bumped under _mutex so a worker about to sleep can't miss it
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued++;
+    }
+    _wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return _unfinished == 0; });
+}
+
+void ThreadPool::work(int index) {
+    currentWorker = index;
+    currentPool = this;
+
+    while (true) {
+        Task task;
+        if (pop(index, task) || steal(index, task)) {
+            task();
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_unfinished == 0) _idle.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [this] { return _queued > 0 || _stopping; });
+        if (_stopping && _queued == 0) return;
+    }
+}
+
+bool ThreadPool::pop(int index, Task &task) {
+    Worker &worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    _queued--;
+    return true;
+}
+
+bool ThreadPool::steal(int index, Task &task) {
+    int count = workerCount();
+    for (int i = 1; i < count; i++) {
+        Worker &victim = *_workers[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        _queued--;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,61 @@
+//
+// Created by Andrew Huang on 10/19/2026.
+//
+
+#ifndef CPPLOX_THREAD_POOL_H
+#define CPPLOX_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "non_copyable.h"
+
+// every worker pops from the back of its own deque and steals from the front of the others
+class ThreadPool : NonCopyable {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(int workers);
+
+    ~ThreadPool();
+
+    // _workers is complete before the first thread starts, _threads still grows while they run
+    [[nodiscard]] inline int workerCount() const { return static_cast<int>(_workers.size()); }
+
+    // called from a worker the task goes to that worker's own deque, otherwise round robin
+    void submit(Task task);
+
+    // blocks until every submitted task has finished
+    void wait();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void work(int index);
+
+    bool pop(int index, Task &task);
+
+    bool steal(int index, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    std::atomic<int> _queued{0};
+    int _unfinished = 0;
+    int _nextWorker = 0;
+    bool _stopping = false;
+};
+
+#endif //CPPLOX_THREAD_POOL_H
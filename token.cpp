@@ -9,8 +9,8 @@
 const char *toString(TokenType type) {
     static const char *STRINGS[]{
             // single-character tokens
-            "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE",
-            "COMMA", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH", "STAR", "PERCENT",
+            "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE", "LEFT_BRACKET", "RIGHT_BRACKET",
+            "COLON", "COMMA", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH", "STAR", "PERCENT",
             // one or two character tokens
             "BANG", "BANG_EQUAL", "EQUAL", "EQUAL_EQUAL",
             "GREATER", "GREATER_EQUAL", "LESS", "LESS_EQUAL",
@@ -18,7 +18,7 @@ const char *toString(TokenType type) {
             "IDENTIFIER", "STRING", "NUMBER",
             // keywords
             "AND", "BREAK", "CLASS", "CONTINUE", "ELSE", "FALSE", "FOR", "FUN", "IF",
-            "NIL", "OR", "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR", "WHILE",
+            "NIL", "OR", "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR", "WHILE", "YIELD",
             // other
             "ERROR", "EOF"
     };
@@ -7,8 +7,8 @@
 
 enum class TokenType {
     // single-character tokens
-    LeftParen, RightParen, LeftBrace, RightBrace,
-    Comma, Dot, Minus, Plus, Semicolon, Slash, Star, Percent,
+    LeftParen, RightParen, LeftBrace, RightBrace, LeftBracket, RightBracket,
+    Colon, Comma, Dot, Minus, Plus, Semicolon, Slash, Star, Percent,
     // one or two character tokens
     Bang, BangEqual, Equal, EqualEqual,
     Greater, GreaterEqual, Less, LessEqual,
@@ -16,7 +16,7 @@ enum class TokenType {
     Identifier, String, Number,
     // keywords
     And, Break, Class, Continue, Else, False, For, Fun, If,
-    Nil, Or, Print, Return, Super, This, True, Var, While,
+    Nil, Or, Print, Return, Super, This, True, Var, While, Yield,
     // other
     Error, Eof
 };
@@ -4,12 +4,38 @@
 
 #include "value.h"
 
-#include <cstdio>
 #include <cmath>
+#include <cstring>
 
+#include "number.h"
 #include "object.h"
 
-Value::Value(const char *chars, int length) : Value(ObjString::create(chars, length)) {}
+Value::Value(VM &vm, const char *chars, int length) {
+    if (length <= SHORT_STRING_MAX) {
+        *this = shortString({chars, static_cast<size_t>(length)}, {});
+    } else {
+        _type = ValueType::Obj;
+        _as.obj = ObjString::create(vm, chars, length);
+    }
+}
+
+Value Value::concatenate(VM &vm, std::string_view a, std::string_view b) {
+    if (a.size() + b.size() <= SHORT_STRING_MAX) return shortString(a, b);
+    return Value(ObjString::concatenate(vm, a, b));
+}
+
+Value Value::shortString(std::string_view a, std::string_view b) {
+    static_assert(sizeof(Value) == 16 && offsetof(Value, _as) == 8, "the jit relies on this layout");
+    static_assert(SHORT_STRING_MAX == sizeof(Value) - offsetof(Value, _inline), "short strings fill the value");
+
+    Value value;
+    value._type = ValueType::ShortString;
+    value._length = static_cast<uint8_t>(a.size() + b.size());
+    char *chars = reinterpret_cast<char *>(&value) + offsetof(Value, _inline);
+    memcpy(chars, a.data(), a.size());
+    memcpy(chars + a.size(), b.data(), b.size());
+    return value;
+}
 
 ObjType Value::objType() const { return asObj()->type; }
 
@@ -17,19 +43,44 @@ bool Value::isString() const { return isObjType(ObjType::String); }
 
 bool Value::isFunction() const { return isObjType(ObjType::Function); }
 
-void Value::print() const {
+bool Value::isNative() const { return isObjType(ObjType::Native); }
+
+bool Value::isList() const { return isObjType(ObjType::List); }
+
+bool Value::isMap() const { return isObjType(ObjType::Map); }
+
+bool Value::isSlice() const { return isObjType(ObjType::Slice); }
+
+bool Value::isText() const { return isShortString() || isString() || isSlice(); }
+
+bool Value::isStringBuilder() const { return isObjType(ObjType::StringBuilder); }
+
+bool Value::isFiber() const { return isObjType(ObjType::Fiber); }
+
+std::string_view Value::asText() const {
+    if (isShortString()) return {shortChars(), _length};
+    if (isString()) return {asString()->chars(), static_cast<size_t>(asString()->length())};
+    return {asSlice()->chars(), static_cast<size_t>(asSlice()->length())};
+}
+
+void Value::print(FILE *out) const {
     switch (_type) {
         case ValueType::Bool:
-            printf(asBool() ? "true" : "false");
+            fprintf(out, asBool() ? "true" : "false");
             break;
         case ValueType::Nil:
-            printf("nil");
+            fprintf(out, "nil");
             break;
-        case ValueType::Number:
-            printf("%g", asNumber());
+        case ValueType::Number: {
+            char digits[NUMBER_MAX_LENGTH];
+            fwrite(digits, 1, formatNumber(asNumber(), digits), out);
             break;
+        }
         case ValueType::Obj:
-            asObj()->print();
+            asObj()->print(out);
+            break;
+        case ValueType::ShortString:
+            fwrite(shortChars(), 1, _length, out);
             break;
     }
 }
@@ -40,10 +91,8 @@ Value Value::operator-() const {
 }
 
 Value Value::operator+(const Value &rhs) const {
-    if (_type != rhs._type) return {};
-    if (isNumber()) return Value(asNumber() + rhs.asNumber());
-    if (isString()) return Value(ObjString::concatenate(asString(), rhs.asString()));
-    return {};
+    if (_type != rhs._type || !isNumber()) return {};
+    return Value(asNumber() + rhs.asNumber());
 }
 
 Value Value::operator-(const Value &rhs) const {
@@ -67,7 +116,10 @@ Value Value::operator%(const Value &rhs) const {
 }
 
 bool Value::operator==(const Value &rhs) const {
-    if (_type != rhs._type) return false;
+    if (_type != rhs._type) {
+        // a short string against a slice or a string made elsewhere
+        return isText() && rhs.isText() && asText() == rhs.asText();
+    }
     switch (_type) {
         case ValueType::Bool:
             return asBool() == rhs.asBool();
@@ -76,7 +128,17 @@ bool Value::operator==(const Value &rhs) const {
         case ValueType::Number:
             return asNumber() == rhs.asNumber();
         case ValueType::Obj:
-            return asObj() == rhs.asObj();
+            // interned strings are equal only if identical, slices and concatenated strings compare characters
+            if (asObj() == rhs.asObj()) return true;
+            if (!isText() || !rhs.isText()) return false;
+            if (isString() && rhs.isString()) {
+                const ObjString *a = asString();
+                const ObjString *b = rhs.asString();
+                if ((a->interned() && b->interned()) || a->length() != b->length()) return false;
+            }
+            return asText() == rhs.asText();
+        case ValueType::ShortString:
+            return _length == rhs._length && memcmp(shortChars(), rhs.shortChars(), _length) == 0;
         default:
             return false;
     }
@@ -5,6 +5,11 @@
 #ifndef CPPLOX_VALUE_H
 #define CPPLOX_VALUE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
 #include "forward.h"
 
 enum class ValueType {
@@ -12,6 +17,7 @@ enum class ValueType {
     Bool,
     Number,
     Obj,
+    ShortString,
 };
 
 class Value {
@@ -22,7 +28,14 @@ public:
 
     explicit inline Value(double value) : _type(ValueType::Number) { _as.number = value; }
 
-    Value(const char *chars, int length);
+    // strings up to this long live inside the value itself, with no object, hash or intern table entry
+    static constexpr int SHORT_STRING_MAX = 11;
+
+    // a short string when it fits, otherwise an interned ObjString
+    Value(VM &vm, const char *chars, int length);
+
+    // only results too long for a short string are allocated
+    static Value concatenate(VM &vm, std::string_view a, std::string_view b);
 
     explicit inline Value(Obj *value) : _type(ValueType::Obj) { _as.obj = value; }
 
@@ -34,6 +47,8 @@ public:
 
     [[nodiscard]] inline bool isObj() const { return _type == ValueType::Obj; }
 
+    [[nodiscard]] inline bool isShortString() const { return _type == ValueType::ShortString; }
+
     [[nodiscard]] inline bool asBool() const { return _as.boolean; }
 
     [[nodiscard]] inline double asNumber() const { return _as.number; }
@@ -48,10 +63,42 @@ public:
 
     [[nodiscard]] bool isFunction() const;
 
+    [[nodiscard]] bool isNative() const;
+
+    [[nodiscard]] bool isList() const;
+
+    [[nodiscard]] bool isMap() const;
+
+    [[nodiscard]] bool isSlice() const;
+
+    // a string, short or not, or a slice of one
+    [[nodiscard]] bool isText() const;
+
+    [[nodiscard]] bool isStringBuilder() const;
+
+    [[nodiscard]] bool isFiber() const;
+
     [[nodiscard]] inline ObjString *asString() const { return reinterpret_cast<ObjString *>(asObj()); }
 
     [[nodiscard]] inline ObjFunction *asFunction() const { return reinterpret_cast<ObjFunction *> (asObj()); }
 
+    [[nodiscard]] inline ObjNative *asNative() const { return reinterpret_cast<ObjNative *> (asObj()); }
+
+    [[nodiscard]] inline ObjList *asList() const { return reinterpret_cast<ObjList *> (asObj()); }
+
+    [[nodiscard]] inline ObjMap *asMap() const { return reinterpret_cast<ObjMap *> (asObj()); }
+
+    [[nodiscard]] inline ObjSlice *asSlice() const { return reinterpret_cast<ObjSlice *> (asObj()); }
+
+    [[nodiscard]] inline ObjStringBuilder *asStringBuilder() const {
+        return reinterpret_cast<ObjStringBuilder *> (asObj());
+    }
+
+    [[nodiscard]] inline ObjFiber *asFiber() const { return reinterpret_cast<ObjFiber *> (asObj()); }
+
+    // only for text, a short string's characters are only valid as long as the value is
+    [[nodiscard]] std::string_view asText() const;
+
     [[nodiscard]] inline bool isFalsey() const { return isNil() || (isBool() && !asBool()); }
 
     Value operator-() const;
@@ -78,10 +125,22 @@ public:
 
     Value operator<=(const Value &rhs) const;
 
-    void print() const;
+    void print(FILE *out) const;
 
 private:
+    friend class JitAssembler;
+
+    static Value shortString(std::string_view a, std::string_view b);
+
+    // start at _inline and run on into _as
+    [[nodiscard]] inline const char *shortChars() const {
+        return reinterpret_cast<const char *>(this) + offsetof(Value, _inline);
+    }
+
     ValueType _type;
+    // only meaningful for short strings, filling what would otherwise be padding
+    uint8_t _length = 0;
+    char _inline[3]{};
     union {
         bool boolean;
         double number;
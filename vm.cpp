@@ -4,11 +4,29 @@
 
 #include "vm.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
 
 #include "compiler.h"
+#include "ir_compiler.h"
+#include "jit.h"
+#include "natives.h"
 #include "object.h"
 #include "op_code.h"
+#include "parallel_compiler.h"
+
+VM::VM() {
+    defineCoreNatives(*this);
+}
+
+VM::VM(std::shared_ptr<StringSpace> sharedStrings, bool internShared)
+        : _sharedStrings(std::move(sharedStrings)), _internShared(internShared) {
+    defineCoreNatives(*this);
+}
 
 VM::~VM() {
     Obj *object = _objects;
@@ -19,43 +37,337 @@ VM::~VM() {
     }
 }
 
+ObjFunction *VM::compile(const char *source) {
+    if (_compileJobs > 1) return compileParallel(*this, source, _compileJobs);
+
+    if (_optimizing) {
+        IrCompiler compiler(*this);
+        return compiler.compile(source);
+    }
+
+    Compiler compiler(*this);
+    return compiler.compile(source);
+}
+
 VM::InterpretResult VM::interpret(const char *source) {
-    Compiler compiler;
-    ObjFunction *function = compiler.compile(source);
+    ObjFunction *function = compile(source);
     if (function == nullptr) return InterpretResult::CompileError;
 
+    return interpret(function);
+}
+
+VM::InterpretResult VM::interpret(const std::shared_ptr<const CodeObject> &code) {
+    if (code->strings() != _sharedStrings) {
+        fprintf(_err, "Code object was built on a different string space.\n");
+        return InterpretResult::RuntimeError;
+    }
+
+    // globals may still point at its strings after it returns
+    _code.push_back(code);
+    return interpret(code->function());
+}
+
+void VM::prepare(ObjFunction *function) { // NOLINT(misc-no-recursion)
+    if (!_jitEnabled || function->jitCode != nullptr || function->frozen) return;
+
+    function->jitCode = JitCode::compile(function->chunk, function->arity);
+    // functions declared inside live in the constant pool
+    for (int i = 0; i < function->chunk.constantCount(); i++) {
+        const Value &constant = function->chunk.constants()[i];
+        if (constant.isFunction()) prepare(constant.asFunction());
+    }
+}
+
+bool VM::busy() const {
+    if (_suspended || !_frames.empty()) {
+        fprintf(_err, "The vm is still running a script.\n");
+        return true;
+    }
+    return false;
+}
+
+VM::InterpretResult VM::finish(InterpretResult result) {
+    _suspended = result == InterpretResult::Suspended;
+    // a failed script leaves its frames behind, the next run starts clean
+    if (result == InterpretResult::RuntimeError) {
+        _stack.clear();
+        while (!_frames.empty()) _frames.pop();
+    }
+    return result;
+}
+
+VM::InterpretResult VM::interpret(ObjFunction *function, int64_t budget) {
+    if (busy()) return InterpretResult::RuntimeError;
+    prepare(function);
+
     push(Value(function));
     _frames.emplace(function, _stack, 0);
 
-    return run();
+    return finish(execute(budget));
+}
+
+VM::InterpretResult VM::run(int64_t budget) {
+    if (!_suspended) {
+        fprintf(_err, "No suspended script to run.\n");
+        return InterpretResult::RuntimeError;
+    }
+
+    _suspended = false;
+    return finish(execute(budget));
 }
 
-void VM::runtimeError(const char *format, ...) const {
+void VM::setGlobal(const char *name, Value value) {
+    _globals.set(Value(ObjString::createShared(*this, name, static_cast<int>(strlen(name)))), value);
+}
+
+bool VM::getGlobal(const char *name, Value &value) {
+    return _globals.get(Value(ObjString::createShared(*this, name, static_cast<int>(strlen(name)))), &value);
+}
+
+VM::InterpretResult VM::call(Value callee, int argCount, const Value *args, Value *result) {
+    if (busy()) return InterpretResult::RuntimeError;
+
+    push(callee);
+    for (int i = 0; i < argCount; i++) {
+        push(args[i]);
+    }
+
+    InterpretResult status = InterpretResult::Ok;
+    if (callee.isFunction()) {
+        ObjFunction *function = callee.asFunction();
+        prepare(function);
+        if (function->arity != argCount) {
+            fprintf(_err, "Expected %d arguments but got %d.\n", function->arity, argCount);
+            status = InterpretResult::RuntimeError;
+        } else {
+            _frames.emplace(function, _stack, 0);
+            status = finish(execute(UNLIMITED));
+            if (status == InterpretResult::Ok && result != nullptr) *result = _returned;
+        }
+    } else if (callee.isNative()) {
+        ObjNative *native = callee.asNative();
+        NativeResult nativeResult = native->function(*this, native->data, argCount, _stack.data() + 1);
+        if (nativeResult == NativeResult::Ok) {
+            if (result != nullptr) *result = _stack[0];
+        } else {
+            status = InterpretResult::RuntimeError;
+        }
+    } else {
+        fprintf(_err, "Can only call functions.\n");
+        status = InterpretResult::RuntimeError;
+    }
+
+    _stack.clear();
+    return status;
+}
+
+VM::InterpretResult VM::call(const char *name, const std::vector<Value> &args, Value *result) {
+    Value callee;
+    if (!getGlobal(name, callee)) {
+        fprintf(_err, "Undefined variable '%s'.\n", name);
+        return InterpretResult::RuntimeError;
+    }
+    return call(callee, static_cast<int>(args.size()), args.data(), result);
+}
+
+Value VM::mapKey(const Value &key) {
+    if (key.isSlice()) {
+        ObjSlice *slice = key.asSlice();
+        if (slice->length() <= Value::SHORT_STRING_MAX) return Value(*this, slice->chars(), slice->length());
+        return Value(slice->intern(*this));
+    }
+    if (key.isString()) return Value(key.asString()->intern(*this));
+    return key;
+}
+
+bool VM::checkIndex(const Value &target, const Value &index, int &slot) {
+    if (target.isMap()) {
+        if (!ObjMap::validKey(index)) {
+            runtimeError("Map key can't be nil or NaN.");
+            return false;
+        }
+        return true;
+    }
+    if (!target.isList()) {
+        runtimeError("Can only index lists and maps.");
+        return false;
+    }
+    if (!index.isNumber()) {
+        runtimeError("List index must be a number.");
+        return false;
+    }
+    if (!target.asList()->index(index.asNumber(), slot)) {
+        runtimeError("List index out of range.");
+        return false;
+    }
+    return true;
+}
+
+bool VM::getIndex(const Value &target, const Value &index, Value &element) {
+    int slot;
+    if (!checkIndex(target, index, slot)) return false;
+
+    if (target.isList()) {
+        element = target.asList()->get(slot);
+    } else if (!target.asMap()->table.get(mapKey(index), &element)) {
+        // a missing key reads as nil, has() tells the two apart
+        element = Value();
+    }
+    return true;
+}
+
+bool VM::setIndex(const Value &target, const Value &index, const Value &value) {
+    int slot;
+    if (!checkIndex(target, index, slot)) return false;
+
+    if (target.isList()) {
+        target.asList()->set(slot, value);
+    } else {
+        target.asMap()->table.set(mapKey(index), value);
+    }
+    return true;
+}
+
+bool VM::call(ObjFunction *function, int argCount) {
+    if (argCount != function->arity) {
+        runtimeError("Expected %d arguments but got %d.", function->arity, argCount);
+        return false;
+    }
+    if (_frames.size() == FRAMES_MAX) {
+        runtimeError("Stack overflow.");
+        return false;
+    }
+
+    _frames.emplace(function, _stack, static_cast<int>(_stack.size()) - argCount - 1);
+    return true;
+}
+
+VM::InterpretResult VM::execute(int64_t budget) {
+    _budget = budget;
+    if (_profiler == nullptr) return run<false>();
+
+    InterpretResult result = run<true>();
+    _profiler->finish();
+    return result;
+}
+
+std::unique_ptr<Fiber> VM::spawn(ObjFunction *function) {
+    prepare(function);
+
+    std::unique_ptr<Fiber> fiber(new Fiber);
+    fiber->_stack.emplace_back(function);
+    // frames always refer to the vm's stack, which holds this fiber's values whenever they're used
+    fiber->_frames.emplace(function, _stack, 0);
+    return fiber;
+}
+
+VM::InterpretResult VM::resume(Fiber &fiber, int64_t budget) {
+    if (fiber._state != Fiber::State::Suspended) {
+        fprintf(_err, "Can only resume a suspended fiber.\n");
+        return InterpretResult::RuntimeError;
+    }
+
+    // resumed from a native, the fiber's stack and frames swap in over those of the code that called it
+    // and it runs on what is left of that code's budget
+    Fiber *resumer = _fiber;
+    bool nested = resumer != nullptr || (!_frames.empty() && !_suspended);
+    int64_t remaining = std::max<int64_t>(_budget, 0);
+    if (nested) budget = std::min(budget, remaining);
+
+    switchTo(fiber);
+    _fiber = &fiber;
+    fiber._nested = nested;
+    fiber._state = Fiber::State::Running;
+
+    InterpretResult result = execute(budget);
+
+    _fiber = resumer;
+    switchTo(fiber);
+    // the resumer is charged for the fiber's backward jumps, when they used up its budget the fiber comes back
+    // Suspended and the native suspends the resumer too
+    if (nested) _budget = remaining - (budget - std::max<int64_t>(_budget, 0));
+    switch (result) {
+        case InterpretResult::Yielded:
+        case InterpretResult::Suspended:
+            fiber._state = Fiber::State::Suspended;
+            break;
+        case InterpretResult::Blocked:
+            fiber._state = Fiber::State::Blocked;
+            break;
+        case InterpretResult::Ok:
+            fiber._state = Fiber::State::Done;
+            fiber._yielded = _returned;
+            break;
+        default:
+            fiber._state = Fiber::State::Failed;
+            break;
+    }
+    return result;
+}
+
+void VM::defineNative(const char *name, NativeFn function, void *data) {
+    ObjString *string = ObjString::createShared(*this, name, static_cast<int>(strlen(name)));
+    _globals.set(Value(string), Value(new ObjNative(*this, function, data, string)));
+}
+
+void VM::runtimeError(const char *format, ...) {
+    // keep what was printed before the error ahead of it
+    _output.flush();
+
     va_list args;
     (va_start(args, format));
-    vfprintf(stderr, format, args);
+    vfprintf(_err, format, args);
     (va_end(args));
-    fprintf(stderr, "\n");
+    fprintf(_err, "\n");
 
     const CallFrame &frame = _frames.top();
     int instruction = static_cast<int>(frame.ip - frame.function->chunk.code() - 1);
     int line = frame.function->chunk.getInstructionLine(instruction);
-    fprintf(stderr, "[line %d] in script\n", line);
+    if (frame.function->name == nullptr) {
+        fprintf(_err, "[line %d] in script\n", line);
+    } else {
+        fprintf(_err, "[line %d] in %s()\n", line, frame.function->name->chars());
+    }
 }
 
+void VM::enterJit(CallFrame &frame) {
+    const JitCode *jit = frame.function->jitCode;
+    Chunk &chunk = frame.function->chunk;
+    int offset = static_cast<int>(frame.ip - chunk.code());
+    if (!jit->canEnter(offset)) return;
+
+    // native code addresses the stack directly, make room for its deepest point up front
+    int base = frame.stackOffset();
+    _stack.resize(base + jit->maxStackDepth());
+    int resume = jit->run(this, _stack.data() + base, chunk.constants(), offset, &_budget);
+    _stack.resize(base + jit->stackDepth(resume));
+    frame.ip = chunk.code() + resume;
+}
+
+template<bool PROFILE>
 VM::InterpretResult VM::run() {
-    CallFrame &frame = _frames.top();
+    CallFrame *frame = &_frames.top();
+    if (!PROFILE && frame->function->jitCode != nullptr) {
+        enterJit(*frame);
+        if (_budget <= 0) return InterpretResult::Suspended;
+    }
 
     while (true) {
+        if constexpr (PROFILE) {
+            const Chunk &chunk = frame->function->chunk;
+            int offset = static_cast<int>(frame->ip - chunk.code());
+            _profiler->instruction(static_cast<OpCode>(*frame->ip), chunk.getInstructionLine(offset));
+        }
+
 #ifdef DEBUG_TRACE_EXECUTION
         printf("          ");
         for (const Value &slot: _stack) {
             printf("[");
-            slot.print();
+            slot.print(stdout);
             printf("]");
         }
         printf("\n");
-        frame.function->chunk.disassembleInstruction(static_cast<int>(frame.ip - frame.function->chunk.code()));
+        frame->function->chunk.disassembleInstruction(static_cast<int>(frame->ip - frame->function->chunk.code()));
 #endif
 
         auto instruction = static_cast<OpCode>(readByte());
@@ -83,35 +395,34 @@ VM::InterpretResult VM::run() {
             }
             case OpCode::GetLocal: {
                 uint8_t slot = readByte();
-                push(frame[slot]);
+                push((*frame)[slot]);
                 break;
             }
             case OpCode::SetLocal: {
                 uint8_t slot = readByte();
-                frame[slot] = peek(0);
+                (*frame)[slot] = peek(0);
                 break;
             }
             case OpCode::GetGlobal: {
-                ObjString *name = readString();
+                Value name = readConstant();
                 Value value;
                 if (!_globals.get(name, &value)) {
-                    runtimeError("Undefined variable '%s'\n", name->chars());
+                    runtimeError("Undefined variable '%s'\n", name.asString()->chars());
                     return InterpretResult::RuntimeError;
                 }
                 push(value);
                 break;
             }
             case OpCode::DefineGlobal: {
-                ObjString *name = readString();
-                _globals.set(name, peek(0));
+                _globals.set(readConstant(), peek(0));
                 pop();
                 break;
             }
             case OpCode::SetGlobal: {
-                ObjString *name = readString();
+                Value name = readConstant();
                 if (_globals.set(name, peek(0))) {
                     _globals.remove(name);
-                    runtimeError("Undefined variable, '%s'.", name->chars());
+                    runtimeError("Undefined variable, '%s'.", name.asString()->chars());
                     return InterpretResult::RuntimeError;
                 }
                 break;
@@ -131,6 +442,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Greater: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::GreaterNumber);
+                }
                 Value result = a > b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -142,6 +456,9 @@ VM::InterpretResult VM::run() {
             case OpCode::GreaterEqual: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::GreaterEqualNumber);
+                }
                 Value result = a >= b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -153,6 +470,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Less: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::LessNumber);
+                }
                 Value result = a < b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -164,6 +484,9 @@ VM::InterpretResult VM::run() {
             case OpCode::LessEqual: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::LessEqualNumber);
+                }
                 Value result = a <= b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -175,6 +498,13 @@ VM::InterpretResult VM::run() {
             case OpCode::Add: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::AddNumber);
+                } else if (a.isText() && b.isText()) {
+                    quicken(*frame, OpCode::ConcatString);
+                    push(Value::concatenate(*this, a.asText(), b.asText()));
+                    break;
+                }
                 Value result = a + b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -186,6 +516,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Subtract: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::SubtractNumber);
+                }
                 Value result = a - b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -197,6 +530,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Multiply: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::MultiplyNumber);
+                }
                 Value result = a * b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -208,6 +544,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Divide: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::DivideNumber);
+                }
                 Value result = a / b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -219,6 +558,9 @@ VM::InterpretResult VM::run() {
             case OpCode::Modulo: {
                 Value b = pop();
                 Value a = pop();
+                if (a.isNumber() && b.isNumber()) {
+                    quicken(*frame, OpCode::ModuloNumber);
+                }
                 Value result = a % b;
                 if (result.isNil()) {
                     runtimeError("Operand must be numbers.");
@@ -227,6 +569,106 @@ VM::InterpretResult VM::run() {
                 push(result);
                 break;
             }
+            case OpCode::GreaterNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Greater);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() > b.asNumber()));
+                break;
+            }
+            case OpCode::GreaterEqualNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::GreaterEqual);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() >= b.asNumber()));
+                break;
+            }
+            case OpCode::LessNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Less);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() < b.asNumber()));
+                break;
+            }
+            case OpCode::LessEqualNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::LessEqual);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() <= b.asNumber()));
+                break;
+            }
+            case OpCode::AddNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Add);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() + b.asNumber()));
+                break;
+            }
+            case OpCode::ConcatString: {
+                if (!peek(0).isText() || !peek(1).isText()) {
+                    dequicken(*frame, OpCode::Add);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value::concatenate(*this, a.asText(), b.asText()));
+                break;
+            }
+            case OpCode::SubtractNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Subtract);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() - b.asNumber()));
+                break;
+            }
+            case OpCode::MultiplyNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Multiply);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() * b.asNumber()));
+                break;
+            }
+            case OpCode::DivideNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Divide);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(a.asNumber() / b.asNumber()));
+                break;
+            }
+            case OpCode::ModuloNumber: {
+                if (!peek(0).isNumber() || !peek(1).isNumber()) {
+                    dequicken(*frame, OpCode::Modulo);
+                    break;
+                }
+                Value b = pop();
+                Value a = pop();
+                push(Value(fmod(a.asNumber(), b.asNumber())));
+                break;
+            }
             case OpCode::Not: {
                 push(Value(pop().isFalsey()));
                 break;
@@ -241,36 +683,147 @@ VM::InterpretResult VM::run() {
                 break;
             }
             case OpCode::Print: {
-                pop().print();
-                printf("\n");
+                _output.writeValue(pop());
+                _output.put('\n');
                 break;
             }
             case OpCode::Jump: {
                 uint16_t offset = readShort();
-                frame.ip += offset;
+                frame->ip += offset;
                 break;
             }
             case OpCode::JumpIfTrue: {
                 uint16_t offset = readShort();
                 if (!peek(0).isFalsey()) {
-                    frame.ip += offset;
+                    frame->ip += offset;
                 }
                 break;
             }
             case OpCode::JumpIfFalse: {
                 uint16_t offset = readShort();
                 if (peek(0).isFalsey()) {
-                    frame.ip += offset;
+                    frame->ip += offset;
+                }
+                break;
+            }
+            case OpCode::PopJumpIfFalse: {
+                uint16_t offset = readShort();
+                if (pop().isFalsey()) {
+                    frame->ip += offset;
                 }
                 break;
             }
             case OpCode::Loop: {
                 uint16_t offset = readShort();
-                frame.ip -= offset;
+                frame->ip -= offset;
+                if (--_budget <= 0) return InterpretResult::Suspended;
+                if (!PROFILE && frame->function->jitCode != nullptr) {
+                    enterJit(*frame);
+                    if (_budget <= 0) return InterpretResult::Suspended;
+                }
+                break;
+            }
+            case OpCode::Call: {
+                int argCount = readByte();
+                Value callee = peek(argCount);
+                if (callee.isFunction()) {
+                    if (!call(callee.asFunction(), argCount)) return InterpretResult::RuntimeError;
+                    frame = &_frames.top();
+                    if (!PROFILE && frame->function->jitCode != nullptr) {
+                        enterJit(*frame);
+                        if (_budget <= 0) return InterpretResult::Suspended;
+                    }
+                    break;
+                }
+                if (!callee.isNative()) {
+                    runtimeError("Can only call functions.");
+                    return InterpretResult::RuntimeError;
+                }
+                ObjNative *native = callee.asNative();
+                size_t args = _stack.size() - argCount;
+                NativeResult result = native->function(*this, native->data, argCount, _stack.data() + args);
+                if (result == NativeResult::Suspend) {
+                    // the callee and its arguments stay put for the call to run again
+                    frame->ip -= 2;
+                    return InterpretResult::Suspended;
+                }
+                _stack.resize(args);
+                if (result == NativeResult::Error) return InterpretResult::RuntimeError;
+                if (result == NativeResult::Block) {
+                    if (_fiber == nullptr) {
+                        runtimeError("Can't wait outside of a fiber.");
+                        return InterpretResult::RuntimeError;
+                    }
+                    return InterpretResult::Blocked;
+                }
                 break;
             }
             case OpCode::Return: {
-                return InterpretResult::Ok;
+                Value result = pop();
+                int base = frame->stackOffset();
+                _frames.pop();
+                _stack.resize(base);
+                if (_frames.empty()) {
+                    _returned = result;
+                    return InterpretResult::Ok;
+                }
+                push(result);
+                frame = &_frames.top();
+                break;
+            }
+            case OpCode::Yield: {
+                if (_fiber == nullptr) {
+                    runtimeError("Can't yield outside of a fiber.");
+                    return InterpretResult::RuntimeError;
+                }
+                _fiber->_yielded = pop();
+                return InterpretResult::Yielded;
+            }
+            case OpCode::BuildList: {
+                int count = readByte();
+                auto list = new ObjList(*this);
+                list->reserve(count);
+                Value *elements = _stack.data() + _stack.size() - count;
+                for (int i = 0; i < count; i++) {
+                    list->append(elements[i]);
+                }
+                _stack.resize(_stack.size() - count);
+                push(Value(list));
+                break;
+            }
+            case OpCode::BuildMap: {
+                int count = readByte();
+                Value *pairs = _stack.data() + _stack.size() - 2 * count;
+                for (int i = 0; i < count; i++) {
+                    if (!ObjMap::validKey(pairs[2 * i])) {
+                        runtimeError("Map key can't be nil or NaN.");
+                        return InterpretResult::RuntimeError;
+                    }
+                }
+                for (int i = 0; i < count; i++) {
+                    pairs[2 * i] = mapKey(pairs[2 * i]);
+                }
+                auto map = new ObjMap(*this);
+                map->table.setAll(pairs, count);
+                _stack.resize(_stack.size() - 2 * count);
+                push(Value(map));
+                break;
+            }
+            case OpCode::GetIndex: {
+                Value element;
+                if (!getIndex(peek(1), peek(0), element)) return InterpretResult::RuntimeError;
+                pop();
+                pop();
+                push(element);
+                break;
+            }
+            case OpCode::SetIndex: {
+                if (!setIndex(peek(2), peek(1), peek(0))) return InterpretResult::RuntimeError;
+                Value value = pop();
+                pop();
+                pop();
+                push(value);
+                break;
             }
             default: {
                 return InterpretResult::RuntimeError;
@@ -5,19 +5,28 @@
 #ifndef CPPLOX_VM_H
 #define CPPLOX_VM_H
 
+#include <cstdint>
+#include <memory>
 #include <stack>
+#include <vector>
 
 #include "chunk.h"
+#include "code_object.h"
 #include "object.h"
-#include "singleton.h"
+#include "op_code.h"
+#include "output_buffer.h"
+#include "profiler.h"
+#include "non_copyable.h"
 #include "table.h"
 
 struct CallFrame {
     ObjFunction *function = nullptr;
-    const uint8_t *ip = nullptr;
+    uint8_t *ip = nullptr;
 
     inline Value &operator[](int slot) { return _stack[_stackOffset + slot]; }
 
+    [[nodiscard]] inline int stackOffset() const { return _stackOffset; }
+
     CallFrame(ObjFunction *function, std::vector<Value> &stack, int stackOffset)
             : function(function), ip(function->chunk.code()), _stack(stack), _stackOffset(stackOffset) {}
 
@@ -26,31 +35,181 @@ private:
     int _stackOffset;
 };
 
-class VM final : public Singleton<VM> {
+// a coroutine, the vm swaps its value stack and call frames in while it runs,
+// so switching costs a few pointer swaps and nothing is copied
+class Fiber : NonCopyable {
+public:
+    enum class State {
+        Suspended,
+        Running,
+        // waiting in a native for a result to be delivered
+        Blocked,
+        Done,
+        Failed,
+    };
+
+    [[nodiscard]] inline State state() const { return _state; }
+
+    // what the last yield passed out, or what the function returned once the fiber is done
+    [[nodiscard]] inline Value yielded() const { return _yielded; }
+
+    // resumed by running code rather than the host, it can't be left blocked for the host to resume later
+    [[nodiscard]] inline bool nested() const { return _nested; }
+
+    // finishes the native call a blocked fiber is waiting in, it can be resumed again after
+    inline void deliver(Value result) {
+        _stack.back() = result;
+        _state = State::Suspended;
+    }
+
+private:
+    friend class VM;
+
+    Fiber() = default;
+
+    std::vector<Value> _stack;
+    std::stack<CallFrame> _frames;
+    State _state = State::Suspended;
+    bool _nested = false;
+    Value _yielded;
+};
+
+class VM final : NonCopyable {
 public:
+    VM();
+
+    // strings from the shared space keep their identity in this vm, needed to run CodeObjects built on it,
+    // with internShared every new string goes there too instead of into this vm's own table,
+    // native and setGlobal names always do, so code frozen after this vm was built still finds them
+    explicit VM(std::shared_ptr<StringSpace> sharedStrings, bool internShared = false);
+
+    ~VM();
+
     enum class InterpretResult {
         Ok,
         CompileError,
         RuntimeError,
+        Yielded,
+        // ran out of budget, run or resume again to continue
+        Suspended,
+        // a native blocked the fiber, resume it once its result was delivered
+        Blocked,
     };
 
+    // budgets count backward jumps, the only way a script can run for long
+    static constexpr int64_t UNLIMITED = INT64_MAX;
+
+    // nullptr after reporting compile errors
+    ObjFunction *compile(const char *source);
+
     InterpretResult interpret(const char *source);
 
+    // runs an already compiled script
+    InterpretResult interpret(ObjFunction *function, int64_t budget = UNLIMITED);
+
+    // continues the script that interpret or an earlier run left suspended
+    InterpretResult run(int64_t budget);
+
+    // runs frozen code built on this vm's shared string space
+    InterpretResult interpret(const std::shared_ptr<const CodeObject> &code);
+
+    // a new fiber that will run function from the start when first resumed
+    std::unique_ptr<Fiber> spawn(ObjFunction *function);
+
+    // host side of the embedding api, none of these can be used while a script is running or suspended
+
+    void setGlobal(const char *name, Value value);
+
+    bool getGlobal(const char *name, Value &value);
+
+    // calls a function or native with args, what it returns lands in result
+    InterpretResult call(Value callee, int argCount, const Value *args, Value *result = nullptr);
+
+    InterpretResult call(const char *name, const std::vector<Value> &args, Value *result = nullptr);
+
+    // tables key objects by identity, so slices and concatenated strings are swapped for their interned string,
+    // or for a short string when they fit in one
+    Value mapKey(const Value &key);
+
+    // runs fiber until it yields, returns, fails or uses up budget,
+    // unlike the rest of the host api a native may call it while a script or another fiber is running
+    InterpretResult resume(Fiber &fiber, int64_t budget = UNLIMITED);
+
+    // the innermost fiber running right now, nullptr outside of resume
+    [[nodiscard]] inline Fiber *currentFiber() const { return _fiber; }
+
+    void defineNative(const char *name, NativeFn function, void *data = nullptr);
+
+    // reports an error with the line of the current instruction, for natives about to return NativeResult::Error
+    void runtimeError(const char *format, ...);
+
+    [[nodiscard]] inline StringSpace *sharedStrings() const { return _sharedStrings.get(); }
+
+    [[nodiscard]] inline bool internsShared() const { return _internShared; }
+
+    inline void setJitEnabled(bool enabled) { _jitEnabled = enabled; }
+
+    // source passed to interpret is compiled on this many threads
+    inline void setCompileJobs(int jobs) { _compileJobs = jobs; }
+
+    // single threaded compiles go through the ir and its optimization passes
+    inline void setOptimizing(bool optimizing) { _optimizing = optimizing; }
+
+    // Print and the disassembler write to out, compile and runtime errors to err,
+    // printed values are buffered and reach out in blocks
+    inline void setOutput(FILE *out, FILE *err) {
+        _output.setSink(OutputBuffer::fileSink(out));
+        _out = out;
+        _err = err;
+    }
+
+    // where printed values go, set its sink to send them somewhere other than a FILE
+    inline OutputBuffer &output() { return _output; }
+
+    [[nodiscard]] inline FILE *outputStream() const { return _out; }
+
+    [[nodiscard]] inline FILE *errorStream() const { return _err; }
+
+    // instructions run in the interpreter only while a profiler is attached
+    inline void setProfiler(Profiler *profiler) { _profiler = profiler; }
+
     inline Table &strings() { return _strings; };
 
     inline Obj *&objects() { return _objects; }
 
 private:
-    friend class Singleton<VM>;
+    friend class JitCode;
 
-    VM() = default;
+    static constexpr size_t FRAMES_MAX = 256;
 
-    ~VM();
+    void prepare(ObjFunction *function);
+
+    // reports and returns true if a script still owns the stack
+    bool busy() const;
+
+    InterpretResult finish(InterpretResult result);
+
+    bool call(ObjFunction *function, int argCount);
 
-    void runtimeError(const char *format, ...) const;
+    // slot is only set for lists
+    bool checkIndex(const Value &target, const Value &index, int &slot);
+
+    bool getIndex(const Value &target, const Value &index, Value &element);
+
+    bool setIndex(const Value &target, const Value &index, const Value &value);
+
+    inline void switchTo(Fiber &fiber) {
+        std::swap(_stack, fiber._stack);
+        std::swap(_frames, fiber._frames);
+    }
 
+    InterpretResult execute(int64_t budget);
+
+    template<bool PROFILE>
     InterpretResult run();
 
+    void enterJit(CallFrame &frame);
+
     inline uint8_t readByte() { return *_frames.top().ip++; }
 
     inline uint16_t readShort() {
@@ -59,9 +218,18 @@ private:
         return static_cast<uint16_t>((currentFrame.ip[-2] << 8) | currentFrame.ip[-1]);
     }
 
-    inline Value readConstant() { return _frames.top().function->chunk.getConstant(readByte()); }
+    // rewrites the instruction that was just read, frozen code is shared and stays generic
+    static inline void quicken(CallFrame &frame, OpCode opCode) {
+        if (!frame.function->frozen) frame.ip[-1] = static_cast<uint8_t>(opCode);
+    }
 
-    inline ObjString *readString() { return readConstant().asString(); }
+    // guard failed, restore the generic instruction and dispatch it again
+    static inline void dequicken(CallFrame &frame, OpCode opCode) {
+        frame.ip[-1] = static_cast<uint8_t>(opCode);
+        frame.ip--;
+    }
+
+    inline Value readConstant() { return _frames.top().function->chunk.getConstant(readByte()); }
 
     inline void push(Value value) { _stack.push_back(value); }
 
@@ -75,9 +243,26 @@ private:
 
     std::stack<CallFrame> _frames;
     std::vector<Value> _stack;
+    // the fiber whose stack and frames are swapped in, nullptr while running a plain script
+    Fiber *_fiber = nullptr;
+    // the plain script ran out of budget and is waiting on run
+    bool _suspended = false;
+    int64_t _budget = UNLIMITED;
+    // what the outermost frame returned
+    Value _returned;
     Table _globals;
     Table _strings;
     Obj *_objects = nullptr;
+    std::shared_ptr<StringSpace> _sharedStrings;
+    bool _internShared = false;
+    std::vector<std::shared_ptr<const CodeObject>> _code;
+    bool _jitEnabled = false;
+    int _compileJobs = 1;
+    bool _optimizing = false;
+    Profiler *_profiler = nullptr;
+    OutputBuffer _output;
+    FILE *_out = stdout;
+    FILE *_err = stderr;
 };
 
 #endif //CPPLOX_VM_H